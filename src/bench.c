@@ -0,0 +1,438 @@
+/*
+ *  Copyright (C) 2026
+ *      Authors (alphabetical) :
+ *		agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ */
+
+/*
+ * phoneui-bench: runs the hot paths of the utils and info functions
+ * against phoneui-fso-mock and reports latency percentiles and heap
+ * allocations per operation. "make bench" runs it on a throwaway session
+ * bus for a few contact counts.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <glib-object.h>
+#include <dbus/dbus-glib.h>
+#include <dbus/dbus-glib-lowlevel.h>
+#include <frameworkd-glib-dbus.h>
+#include "phoneui.h"
+#include "phoneui-utils.h"
+#include "phoneui-utils-contacts.h"
+#include "phoneui-utils-messages.h"
+#include "phoneui-info.h"
+
+/* glibc's own allocator, wrapped below to count the allocations */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static unsigned long allocations = 0;
+
+void *
+malloc(size_t size)
+{
+	__sync_fetch_and_add(&allocations, 1);
+	return __libc_malloc(size);
+}
+
+void *
+calloc(size_t n, size_t size)
+{
+	__sync_fetch_and_add(&allocations, 1);
+	return __libc_calloc(n, size);
+}
+
+void *
+realloc(void *ptr, size_t size)
+{
+	__sync_fetch_and_add(&allocations, 1);
+	return __libc_realloc(ptr, size);
+}
+
+struct _bench {
+	const char *name;
+	GArray *samples;	/* ms per operation */
+	unsigned long allocations;
+	int ops;
+	gdouble started;
+	unsigned long allocations_started;
+};
+
+static GTimer *timer = NULL;
+static int contacts = 1000;
+static int iterations = 100;
+
+/* state of the operation being waited for */
+static int pending = 0;
+static GHashTable **kept = NULL;
+static int kept_count = 0;
+
+static void
+_bench_init(struct _bench *b, const char *name)
+{
+	b->name = name;
+	b->samples = g_array_new(FALSE, FALSE, sizeof(gdouble));
+	b->allocations = 0;
+	b->ops = 0;
+}
+
+static void
+_bench_begin(struct _bench *b)
+{
+	b->allocations_started = allocations;
+	b->started = g_timer_elapsed(timer, NULL);
+}
+
+/* one sample covering n operations */
+static void
+_bench_end(struct _bench *b, int n)
+{
+	gdouble ms;
+
+	ms = (g_timer_elapsed(timer, NULL) - b->started) * 1000 / n;
+	b->allocations += allocations - b->allocations_started;
+	b->ops += n;
+	g_array_append_val(b->samples, ms);
+}
+
+static gint
+_compare_doubles(gconstpointer a, gconstpointer b)
+{
+	gdouble da = *(const gdouble *) a, db = *(const gdouble *) b;
+
+	return (da > db) - (da < db);
+}
+
+static gdouble
+_percentile(GArray *samples, int percentile)
+{
+	return g_array_index(samples, gdouble,
+			     (samples->len - 1) * percentile / 100);
+}
+
+static void
+_bench_report(struct _bench *b)
+{
+	if (!b->samples->len) {
+		printf("%-34s %7s\n", b->name, "failed");
+		return;
+	}
+	g_array_sort(b->samples, _compare_doubles);
+	printf("%-34s %7d %9.4f %9.4f %9.4f %9.1f\n", b->name, b->ops,
+	       _percentile(b->samples, 50), _percentile(b->samples, 90),
+	       _percentile(b->samples, 99),
+	       (gdouble) b->allocations / b->ops);
+	g_array_free(b->samples, TRUE);
+}
+
+/* percentiles the library itself sampled, see latency.c */
+static void
+_latency_report(const char *name, const char *op)
+{
+	if (phoneui_latency_percentile_get(op, 50) < 0)
+		return;
+	printf("%-34s %7s %9.4f %9.4f %9.4f %9s\n", name, "-",
+	       phoneui_latency_percentile_get(op, 50),
+	       phoneui_latency_percentile_get(op, 90),
+	       phoneui_latency_percentile_get(op, 99), "-");
+}
+
+static void
+_wait()
+{
+	while (pending > 0) {
+		g_main_context_iteration(NULL, TRUE);
+	}
+}
+
+static void
+_query_callback(GError *error, GHashTable **results, int count, gpointer data)
+{
+	(void) data;
+	int i;
+
+	if (error) {
+		g_warning("Query failed: %s", error->message);
+	}
+	/* keep the first results for the display name benchmarks */
+	if (!kept && results) {
+		kept = results;
+		kept_count = count;
+	}
+	else if (results) {
+		for (i = 0; i < count; i++) {
+			g_hash_table_unref(results[i]);
+		}
+		g_free(results);
+	}
+	pending--;
+}
+
+static void
+_bench_pim_query()
+{
+	int i;
+	struct _bench b;
+
+	_bench_init(&b, "pim query, all contacts");
+	for (i = 0; i < iterations; i++) {
+		pending = 1;
+		_bench_begin(&b);
+		phoneui_utils_pim_query(PHONEUI_PIM_DOMAIN_CONTACTS, NULL,
+					FALSE, FALSE, 0, -1, FALSE, NULL,
+					_query_callback, NULL);
+		_wait();
+		_bench_end(&b, 1);
+	}
+	_bench_report(&b);
+}
+
+static void
+_record_callback(struct PhoneuiContact *record, gpointer data)
+{
+	(void) data;
+
+	phoneui_utils_contact_record_free(record);
+	pending--;
+}
+
+static void
+_bench_contacts_get()
+{
+	int i, count;
+	struct _bench b;
+
+	_bench_init(&b, "contacts get, sorted records");
+	phoneui_latency_reset();
+	for (i = 0; i < MAX(iterations / 10, 5); i++) {
+		pending = contacts;
+		_bench_begin(&b);
+		phoneui_utils_contacts_get_records(&count, _record_callback, NULL);
+		_wait();
+		_bench_end(&b, 1);
+	}
+	_bench_report(&b);
+	_latency_report("  of that sorting", "contacts sort");
+	_latency_report("  sorting per contact", "contacts sort per contact");
+}
+
+static void
+_bench_display()
+{
+	int i, j;
+	char *s;
+	struct _bench name, phone;
+
+	if (!kept || kept_count <= 0)
+		return;
+	_bench_init(&name, "contact display name get");
+	_bench_init(&phone, "contact display phone get");
+	for (i = 0; i < iterations; i++) {
+		_bench_begin(&name);
+		for (j = 0; j < kept_count; j++) {
+			s = phoneui_utils_contact_display_name_get(kept[j]);
+			free(s);
+		}
+		_bench_end(&name, kept_count);
+		_bench_begin(&phone);
+		for (j = 0; j < kept_count; j++) {
+			s = phoneui_utils_contact_display_phone_get(kept[j]);
+			free(s);
+		}
+		_bench_end(&phone, kept_count);
+	}
+	_bench_report(&name);
+	_bench_report(&phone);
+}
+
+static void
+_lookup_callback(GError *error, GHashTable *contact, gpointer data)
+{
+	(void) error;
+	(void) contact;
+	(void) data;
+
+	pending--;
+}
+
+static void
+_bench_lookup()
+{
+	int i;
+	char number[32];
+	struct _bench b;
+
+	_bench_init(&b, "contact lookup");
+	phoneui_latency_reset();
+	for (i = 0; i < iterations; i++) {
+		snprintf(number, sizeof(number), "+49170%07d",
+			 (i * 7919) % contacts);
+		pending = 1;
+		_bench_begin(&b);
+		phoneui_utils_contact_lookup(number, _lookup_callback, NULL);
+		_wait();
+		_bench_end(&b, 1);
+	}
+	_bench_report(&b);
+	_latency_report("  served from the index", "contact lookup cached");
+	_latency_report("  asking opimd", "contact lookup query");
+}
+
+static void
+_message_changed(void *data, const char *path, enum PhoneuiInfoChangeType type)
+{
+	(void) data;
+	(void) path;
+	(void) type;
+
+	pending--;
+}
+
+static void
+_message_added(GError *error, char *path, gpointer data)
+{
+	(void) error;
+	(void) data;
+
+	free(path);
+	pending--;
+}
+
+static void
+_bench_dispatch()
+{
+	int i, subscribers = 0;
+	int counts[] = { 1, 10, 100, 0 };
+	char name[64];
+	struct _bench *b;
+	int c;
+
+	for (c = 0; counts[c]; c++) {
+		while (subscribers < counts[c]) {
+			phoneui_info_register_message_changes(_message_changed,
+							      NULL);
+			subscribers++;
+		}
+		snprintf(name, sizeof(name), "info dispatch, %d subscribers",
+			 subscribers);
+		b = malloc(sizeof(*b));
+		_bench_init(b, name);
+		phoneui_latency_reset();
+		for (i = 0; i < MAX(iterations / 10, 5); i++) {
+			/* the add itself and one signal per subscriber */
+			pending = 1 + subscribers;
+			_bench_begin(b);
+			phoneui_utils_message_add_fields("in", 0, "bench", "SMS",
+					TRUE, "+491700000000", _message_added,
+					NULL);
+			_wait();
+			_bench_end(b, subscribers);
+		}
+		_bench_report(b);
+		_latency_report("  dispatch per subscriber", "info dispatch");
+		free(b);
+	}
+}
+
+static gboolean
+_mock_start(const char *mock)
+{
+	int i;
+	char count[16], messages[16];
+	char *argv[] = { (char *) mock, "--contacts", count, "--messages",
+			 messages, NULL };
+	GError *error = NULL;
+	DBusGConnection *bus;
+
+	snprintf(count, sizeof(count), "%d", contacts);
+	snprintf(messages, sizeof(messages), "%d", contacts * 5);
+	if (!g_spawn_async(NULL, argv, NULL, G_SPAWN_STDOUT_TO_DEV_NULL,
+			   NULL, NULL, NULL, &error)) {
+		fprintf(stderr, "Can't start %s: %s\n", mock, error->message);
+		g_error_free(error);
+		return FALSE;
+	}
+
+	bus = dbus_g_bus_get(DBUS_BUS_SESSION, NULL);
+	if (!bus)
+		return FALSE;
+	/* generating the data takes a moment */
+	for (i = 0; i < 300; i++) {
+		if (dbus_bus_name_has_owner(dbus_g_connection_get_connection(bus),
+					    "org.freesmartphone.opimd", NULL))
+			return TRUE;
+		g_usleep(100000);
+	}
+	fprintf(stderr, "%s didn't show up on the bus\n", mock);
+	return FALSE;
+}
+
+int
+main(int argc, char **argv)
+{
+	int i;
+	const char *mock = "./phoneui-fso-mock";
+	const char *address;
+
+	for (i = 1; i + 1 < argc; i += 2) {
+		if (!strcmp(argv[i], "--mock"))
+			mock = argv[i + 1];
+		else if (!strcmp(argv[i], "--contacts"))
+			contacts = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "--iterations"))
+			iterations = atoi(argv[i + 1]);
+	}
+	if (contacts <= 0 || iterations <= 0) {
+		fprintf(stderr, "usage: %s [--mock PATH] [--contacts N] "
+			"[--iterations N]\n", argv[0]);
+		return 1;
+	}
+
+	/* GSlice would hide allocations from the counting */
+	setenv("G_SLICE", "always-malloc", 1);
+	address = getenv("DBUS_SESSION_BUS_ADDRESS");
+	if (!address) {
+		fprintf(stderr, "No session bus to run on, see make bench\n");
+		return 1;
+	}
+	/* everything, libframeworkd-glib included, talks to the mock */
+	setenv("PHONEUI_BUS", "session", 1);
+	setenv("DBUS_SYSTEM_BUS_ADDRESS", address, 1);
+
+	g_type_init();
+	timer = g_timer_new();
+	if (!_mock_start(mock))
+		return 1;
+	/* contact_get still goes through libframeworkd-glib */
+	frameworkd_handler_connect(NULL);
+	phoneui_latency_enable(TRUE);
+
+	printf("\n%d contacts, %d iterations\n", contacts, iterations);
+	printf("%-34s %7s %9s %9s %9s %9s\n", "operation", "ops", "p50 ms",
+	       "p90 ms", "p99 ms", "allocs/op");
+	_bench_pim_query();
+	_bench_contacts_get();
+	_bench_display();
+	_bench_lookup();
+	_bench_dispatch();
+
+	return 0;
+}
@@ -0,0 +1,103 @@
+/*
+ *  Copyright (C) 2026
+ *      Authors (alphabetical) :
+ *		agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ */
+
+#include <stdlib.h>
+#include <glib.h>
+#include "phoneui-utils.h"
+#include "cancel.h"
+
+/* handle -> struct _cancellable, for the running operations */
+static GHashTable *running = NULL;
+static int last_handle = 0;
+
+struct _cancellable *
+_cancellable_new()
+{
+	struct _cancellable *cancellable;
+
+	cancellable = malloc(sizeof(*cancellable));
+	if (!cancellable)
+		return NULL;
+	if (!running) {
+		running = g_hash_table_new(g_direct_hash, g_direct_equal);
+	}
+
+	/* 0 is never a valid handle */
+	do {
+		if (++last_handle <= 0)
+			last_handle = 1;
+	} while (g_hash_table_lookup(running, GINT_TO_POINTER(last_handle)));
+
+	cancellable->handle = last_handle;
+	cancellable->cancelled = FALSE;
+	g_hash_table_insert(running, GINT_TO_POINTER(cancellable->handle),
+			    cancellable);
+	return cancellable;
+}
+
+gboolean
+_cancellable_cancelled(const struct _cancellable *cancellable)
+{
+	return cancellable && cancellable->cancelled;
+}
+
+void
+_cancellable_free(struct _cancellable *cancellable)
+{
+	if (!cancellable)
+		return;
+	if (running && !cancellable->cancelled) {
+		g_hash_table_remove(running,
+				    GINT_TO_POINTER(cancellable->handle));
+	}
+	free(cancellable);
+}
+
+void
+_cancel_results_drop(GHashTable **results, int count)
+{
+	int i;
+
+	if (!results)
+		return;
+	for (i = 0; i < count; i++) {
+		if (results[i])
+			g_hash_table_unref(results[i]);
+	}
+	g_free(results);
+}
+
+int
+phoneui_utils_cancel(int handle)
+{
+	struct _cancellable *cancellable;
+
+	if (!running || handle <= 0)
+		return 1;
+	cancellable = g_hash_table_lookup(running, GINT_TO_POINTER(handle));
+	if (!cancellable) {
+		/* already done */
+		return 1;
+	}
+	g_debug("Cancelling operation %d", handle);
+	cancellable->cancelled = TRUE;
+	g_hash_table_remove(running, GINT_TO_POINTER(handle));
+	return 0;
+}
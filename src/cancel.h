@@ -0,0 +1,39 @@
+/*
+ *  Copyright (C) 2026
+ *      Authors (alphabetical) :
+ *		agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ */
+#ifndef _CANCEL_H
+#define _CANCEL_H
+
+#include <glib.h>
+
+/* carried by the pack of a cancellable operation, its handle is what
+ * the caller gets back and can pass to phoneui_utils_cancel. The owner
+ * checks for cancellation before calling back and frees it when done */
+struct _cancellable {
+	int handle;
+	gboolean cancelled;
+};
+
+struct _cancellable *_cancellable_new();
+gboolean _cancellable_cancelled(const struct _cancellable *cancellable);
+void _cancellable_free(struct _cancellable *cancellable);
+/* drop results nobody is waiting for anymore */
+void _cancel_results_drop(GHashTable **results, int count);
+
+#endif
@@ -0,0 +1,326 @@
+/*
+ *  Copyright (C) 2026
+ *      Authors (alphabetical) :
+ *		agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ */
+
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <glib-object.h>
+#include <phone-utils.h>
+#include "phoneui-info.h"
+#include "phoneui-utils-contacts.h"
+#include "contacts-index.h"
+
+enum _index_state {
+	INDEX_EMPTY,
+	INDEX_BUILDING,
+	INDEX_READY
+};
+
+struct _index_entry {
+	char *path;
+	GHashTable *contact;
+	char *display_name;
+	GPtrArray *numbers;
+};
+
+static enum _index_state _state = INDEX_EMPTY;
+static gboolean _changes_registered = FALSE;
+/* normalized number -> contact path, both owned by the entry */
+static GHashTable *_numbers = NULL;
+/* contact path -> struct _index_entry */
+static GHashTable *_entries = NULL;
+/* paths of the contacts that changed while building, the bulk results
+ * might predate those changes */
+static GHashTable *_changed = NULL;
+
+static char *
+_normalize_number(const char *number)
+{
+	char *ret;
+
+	if (!number || !*number)
+		return NULL;
+	ret = strdup(number);
+	if (ret) {
+		phone_utils_remove_filler_chars(ret);
+	}
+	if (ret && !*ret) {
+		free(ret);
+		ret = NULL;
+	}
+	return ret;
+}
+
+static void
+_add_number(struct _index_entry *entry, const char *number)
+{
+	char *normalized = _normalize_number(number);
+
+	if (!normalized)
+		return;
+	g_ptr_array_add(entry->numbers, normalized);
+	g_hash_table_replace(_numbers, normalized, entry->path);
+}
+
+static void
+_entry_free(gpointer data)
+{
+	guint i;
+	struct _index_entry *entry = data;
+
+	for (i = 0; i < entry->numbers->len; i++) {
+		const char *number = g_ptr_array_index(entry->numbers, i);
+		/* only drop the number if nobody else took it over */
+		if (g_hash_table_lookup(_numbers, number) == entry->path) {
+			g_hash_table_remove(_numbers, number);
+		}
+		free(g_ptr_array_index(entry->numbers, i));
+	}
+	g_ptr_array_free(entry->numbers, TRUE);
+	if (entry->contact) {
+		g_hash_table_unref(entry->contact);
+	}
+	free(entry->display_name);
+	free(entry->path);
+	free(entry);
+}
+
+static void
+_index_contact(const char *path, GHashTable *contact)
+{
+	gpointer _key, _val;
+	GHashTableIter iter;
+	struct _index_entry *entry;
+
+	/* drop what we knew about that contact before */
+	g_hash_table_remove(_entries, path);
+
+	entry = malloc(sizeof(*entry));
+	entry->path = strdup(path);
+	entry->contact = g_hash_table_ref(contact);
+	entry->display_name = phoneui_utils_contact_display_name_get(contact);
+	entry->numbers = g_ptr_array_new();
+
+	/* same notion of phone fields as phoneui_utils_contact_display_phone_get */
+	g_hash_table_iter_init(&iter, contact);
+	while (g_hash_table_iter_next(&iter, &_key, &_val)) {
+		const char *key = (const char *)_key;
+		const GValue *val = (const GValue *) _val;
+
+		if (!val || !G_IS_VALUE(val))
+			continue;
+		if (!strstr(key, "Phone") && !strstr(key, "phone"))
+			continue;
+
+		if (G_VALUE_HOLDS_BOXED(val)) {
+			char **strv = (char **)g_value_get_boxed(val);
+			for (; strv && *strv; strv++) {
+				_add_number(entry, *strv);
+			}
+		}
+		else if (G_VALUE_HOLDS_STRING(val)) {
+			_add_number(entry, g_value_get_string(val));
+		}
+	}
+
+	g_hash_table_insert(_entries, entry->path, entry);
+}
+
+static void
+_contact_get_callback(GError *error, GHashTable *contact, gpointer data)
+{
+	char *path = data;
+
+	if (error || !contact || _state == INDEX_EMPTY) {
+		free(path);
+		return;
+	}
+	g_debug("Reindexing contact %s", path);
+	_index_contact(path, contact);
+	free(path);
+}
+
+static void
+_contact_changed_callback(void *data, const char *path,
+			  enum PhoneuiInfoChangeType type)
+{
+	(void) data;
+
+	if (_state == INDEX_EMPTY)
+		return;
+	if (_state == INDEX_BUILDING) {
+		g_hash_table_replace(_changed, g_strdup(path), NULL);
+		return;
+	}
+
+	switch (type) {
+	case PHONEUI_INFO_CHANGE_NEW:
+	case PHONEUI_INFO_CHANGE_UPDATE:
+		/* the update signal only carries the changed fields */
+		phoneui_utils_contact_get(path, _contact_get_callback,
+					  strdup(path));
+		break;
+	case PHONEUI_INFO_CHANGE_DELETE:
+		g_debug("Removing contact %s from the index", path);
+		g_hash_table_remove(_entries, path);
+		break;
+	}
+}
+
+static void
+_changed_replay()
+{
+	GHashTableIter iter;
+	gpointer path;
+
+	/* deleted ones stay removed as fetching them fails */
+	g_hash_table_iter_init(&iter, _changed);
+	while (g_hash_table_iter_next(&iter, &path, NULL)) {
+		g_debug("Contact %s changed while building the index",
+			(char *) path);
+		g_hash_table_remove(_entries, path);
+		phoneui_utils_contact_get(path, _contact_get_callback,
+					  strdup(path));
+	}
+	g_hash_table_remove_all(_changed);
+}
+
+static void
+_contacts_callback(GError *error, GHashTable **contacts, int count,
+		   gpointer data)
+{
+	(void) data;
+	int i;
+	const GValue *tmp;
+
+	if (_state != INDEX_BUILDING) {
+		/* got deinited meanwhile */
+		for (i = 0; contacts && i < count; i++) {
+			g_hash_table_unref(contacts[i]);
+		}
+		g_free(contacts);
+		return;
+	}
+
+	if (error) {
+		g_warning("Failed building the contacts index: (%d) %s",
+			  error->code, error->message);
+		_state = INDEX_EMPTY;
+		g_hash_table_remove_all(_changed);
+		return;
+	}
+
+	for (i = 0; i < count; i++) {
+		tmp = g_hash_table_lookup(contacts[i], "Path");
+		if (tmp) {
+			_index_contact(g_value_get_string(tmp), contacts[i]);
+		}
+		g_hash_table_unref(contacts[i]);
+	}
+	g_free(contacts);
+
+	g_debug("Contacts index ready: %d contacts, %d numbers",
+		g_hash_table_size(_entries), g_hash_table_size(_numbers));
+	_state = INDEX_READY;
+	_changed_replay();
+}
+
+static void
+_index_build()
+{
+	_state = INDEX_BUILDING;
+	if (!_numbers) {
+		_numbers = g_hash_table_new(g_str_hash, g_str_equal);
+		_entries = g_hash_table_new_full(g_str_hash, g_str_equal,
+						 NULL, _entry_free);
+		_changed = g_hash_table_new_full(g_str_hash, g_str_equal,
+						 g_free, NULL);
+	}
+	if (!_changes_registered) {
+		phoneui_info_register_contact_changes
+					(_contact_changed_callback, NULL);
+		_changes_registered = TRUE;
+	}
+
+	g_debug("Building the contacts index");
+	phoneui_utils_contacts_query(NULL, FALSE, FALSE, 0, -1, NULL,
+				     _contacts_callback, NULL);
+}
+
+static struct _index_entry *
+_index_lookup(const char *number)
+{
+	char *normalized;
+	const char *path;
+
+	if (_state == INDEX_EMPTY) {
+		_index_build();
+		return NULL;
+	}
+	if (_state != INDEX_READY)
+		return NULL;
+
+	normalized = _normalize_number(number);
+	if (!normalized)
+		return NULL;
+	path = g_hash_table_lookup(_numbers, normalized);
+	free(normalized);
+
+	return (path) ? g_hash_table_lookup(_entries, path) : NULL;
+}
+
+GHashTable *
+_contacts_index_lookup(const char *number)
+{
+	struct _index_entry *entry = _index_lookup(number);
+
+	return (entry) ? g_hash_table_ref(entry->contact) : NULL;
+}
+
+char *
+_contacts_index_lookup_name(const char *number)
+{
+	struct _index_entry *entry = _index_lookup(number);
+
+	return (entry && entry->display_name) ?
+		strdup(entry->display_name) : NULL;
+}
+
+void
+_contacts_index_deinit()
+{
+	_state = INDEX_EMPTY;
+	if (_entries) {
+		g_hash_table_destroy(_entries);
+		_entries = NULL;
+	}
+	if (_numbers) {
+		g_hash_table_destroy(_numbers);
+		_numbers = NULL;
+	}
+	if (_changed) {
+		g_hash_table_destroy(_changed);
+		_changed = NULL;
+	}
+	/* phoneui_info_deinit dropped the subscription */
+	_changes_registered = FALSE;
+}
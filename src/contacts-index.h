@@ -0,0 +1,32 @@
+/*
+ *  Copyright (C) 2026
+ *      Authors (alphabetical) :
+ *		agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ */
+
+#ifndef _CONTACTS_INDEX_H
+#define _CONTACTS_INDEX_H
+
+#include <glib.h>
+
+/* in-process index of the contacts by phone number - it gets built on the
+ * first lookup, until it is ready all lookups miss */
+GHashTable *_contacts_index_lookup(const char *number);
+char *_contacts_index_lookup_name(const char *number);
+void _contacts_index_deinit();
+
+#endif
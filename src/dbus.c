@@ -20,16 +20,75 @@
 
 
 
+#include <stdlib.h>
+#include <string.h>
 #include <dbus/dbus-glib.h>
+#include <dbus/dbus-glib-lowlevel.h>
 #include "dbus.h"
 
 static DBusGConnection *_bus = NULL;
+/* "system", "session" or the address of a private bus - the
+ * PHONEUI_BUS environment variable overrides the config */
+static char *_bus_name = NULL;
+
+/* proxies shared by all the utils functions, keyed by
+ * "busname:path:interface" - the interface is identified by the name
+ * of the getter used to create the proxy */
+static GHashTable *_proxies = NULL;
+
+struct _proxy_entry {
+	char *busname;
+	GObject *proxy;
+};
+
+void
+_dbus_set_bus(const char *bus)
+{
+	free(_bus_name);
+	_bus_name = (bus) ? strdup(bus) : NULL;
+}
+
+static DBusGConnection *
+_dbus_bus_open(GError **error)
+{
+	const char *bus;
+	DBusGConnection *conn;
+	DBusError derror;
+
+	bus = g_getenv("PHONEUI_BUS");
+	if (!bus)
+		bus = _bus_name;
+	if (!bus || !strcmp(bus, "system"))
+		return dbus_g_bus_get(DBUS_BUS_SYSTEM, error);
+	if (!strcmp(bus, "session")) {
+		g_message("Using the session bus for the FSO services");
+		return dbus_g_bus_get(DBUS_BUS_SESSION, error);
+	}
+
+	g_message("Using the bus at %s for the FSO services", bus);
+	conn = dbus_g_connection_open(bus, error);
+	if (!conn)
+		return NULL;
+	/* a connection of our own has to say hello before it can call
+	 * services or get their signals */
+	dbus_error_init(&derror);
+	if (!dbus_bus_register(dbus_g_connection_get_connection(conn),
+			       &derror)) {
+		g_set_error(error, DBUS_GERROR, DBUS_GERROR_FAILED,
+			    "%s", derror.message);
+		dbus_error_free(&derror);
+		dbus_g_connection_unref(conn);
+		return NULL;
+	}
+	return conn;
+}
 
 DBusGConnection *_dbus()
 {
 	GError *error = NULL;
+
 	if (!_bus) {
-		_bus = dbus_g_bus_get(DBUS_BUS_SYSTEM, &error);
+		_bus = _dbus_bus_open(&error);
 		if (error) {
 			g_critical("Failed to get on the bus: (%d) %s",
 				   error->code, error->message);
@@ -39,3 +98,86 @@ DBusGConnection *_dbus()
 	}
 	return _bus;
 }
+
+static void
+_proxy_entry_free(gpointer data)
+{
+	struct _proxy_entry *entry = data;
+
+	g_object_unref(entry->proxy);
+	free(entry->busname);
+	free(entry);
+}
+
+gpointer
+_dbus_proxy(void *(*proxy_get)(DBusGConnection *, const char *, const char *),
+	    const char *iface, const char *busname, const char *path)
+{
+	struct _proxy_entry *entry;
+	char *key;
+
+	if (!_proxies) {
+		_proxies = g_hash_table_new_full(g_str_hash, g_str_equal,
+						 g_free, _proxy_entry_free);
+	}
+
+	key = g_strdup_printf("%s:%s:%s", busname, path, iface);
+	entry = g_hash_table_lookup(_proxies, key);
+	if (entry) {
+		g_free(key);
+		return g_object_ref(entry->proxy);
+	}
+
+	entry = malloc(sizeof(*entry));
+	if (!entry) {
+		g_warning("Failed allocating proxy entry for %s", key);
+		g_free(key);
+		return NULL;
+	}
+	entry->proxy = proxy_get(_dbus(), busname, path);
+	if (!entry->proxy) {
+		g_warning("Failed creating proxy for %s", key);
+		free(entry);
+		g_free(key);
+		return NULL;
+	}
+	entry->busname = strdup(busname);
+	g_debug("Created shared proxy for %s", key);
+	g_hash_table_insert(_proxies, key, entry);
+
+	return g_object_ref(entry->proxy);
+}
+
+static gboolean
+_proxy_entry_matches(gpointer key, gpointer value, gpointer data)
+{
+	(void) key;
+	struct _proxy_entry *entry = value;
+
+	return !strcmp(entry->busname, (const char *)data);
+}
+
+void
+_dbus_proxies_invalidate(const char *busname)
+{
+	guint count;
+
+	if (!_proxies || !busname)
+		return;
+
+	/* in-flight calls still hold their own reference */
+	count = g_hash_table_foreach_remove(_proxies, _proxy_entry_matches,
+					    (gpointer) busname);
+	if (count) {
+		g_debug("Dropped %d cached proxies for %s", count, busname);
+	}
+}
+
+void
+_dbus_proxies_clear()
+{
+	if (_proxies) {
+		g_hash_table_destroy(_proxies);
+		_proxies = NULL;
+	}
+}
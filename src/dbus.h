@@ -24,5 +24,17 @@
 #include <dbus/dbus-glib.h>
 
 DBusGConnection *_dbus();
+/* the bus _dbus connects to - only libphone-ui's own calls use it, the
+ * environment of the process is left alone */
+void _dbus_set_bus(const char *bus);
+
+/* returns a new reference to a shared proxy - release it with g_object_unref */
+#define _DBUS_PROXY(func, busname, path) \
+	_dbus_proxy((void *(*)(DBusGConnection *, const char *, const char *)) func, \
+		    #func, busname, path)
+
+gpointer _dbus_proxy(void *(*proxy_get)(DBusGConnection *, const char *, const char *), const char *iface, const char *busname, const char *path);
+void _dbus_proxies_invalidate(const char *busname);
+void _dbus_proxies_clear();
 
 #endif
@@ -0,0 +1,1131 @@
+/*
+ *  Copyright (C) 2026
+ *      Authors (alphabetical) :
+ *		agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ */
+
+/*
+ * phoneui-fso-mock: stand-in for opimd, ogsmd and ousaged on a private
+ * bus, with synthetic data of a configurable size and an injectable reply
+ * latency. Start a bus, run the mock on it and point libphone-ui there:
+ *
+ *   addr=$(dbus-daemon --session --fork --print-address)
+ *   phoneui-fso-mock --bus "$addr" --contacts 10000 --messages 50000 &
+ *   PHONEUI_BUS="$addr" some-phoneui-app
+ *
+ * libframeworkd-glib, used for contact_get and friends, ignores
+ * PHONEUI_BUS - set DBUS_SYSTEM_BUS_ADDRESS="$addr" as well to point it
+ * to the mock too.
+ *
+ * Only plain libdbus is used, so it runs on any Linux box.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/time.h>
+#include <dbus/dbus.h>
+
+#define PIM_PATH "/org/freesmartphone/PIM"
+#define PIM_IFACE "org.freesmartphone.PIM"
+#define GSM_PATH "/org/freesmartphone/GSM/Device"
+#define USAGE_PATH "/org/freesmartphone/Usage"
+
+enum _domain_type {
+	DOMAIN_CONTACTS,
+	DOMAIN_MESSAGES,
+	DOMAIN_CALLS,
+	DOMAIN_DATES,
+	DOMAINS
+};
+
+struct _field {
+	char *name;
+	int type;		/* DBUS_TYPE_STRING, _INT32 or _BOOLEAN */
+	char *s;
+	int i;
+};
+
+struct _entry {
+	int deleted;
+	int count;
+	struct _field *fields;
+};
+
+struct _domain {
+	const char *name;	/* collection, e.g. Contacts */
+	const char *single;	/* entry, e.g. Contact */
+	struct _entry *entries;
+	int count;
+	int size;
+};
+
+struct _query {
+	int id;
+	int domain;
+	int *matches;
+	int count;
+	int pos;
+	struct _query *next;
+};
+
+struct _delayed {
+	long long due;
+	DBusMessage *reply;
+	struct _delayed *next;
+};
+
+static struct _domain domains[DOMAINS] = {
+	{ "Contacts", "Contact", NULL, 0, 0 },
+	{ "Messages", "Message", NULL, 0, 0 },
+	{ "Calls", "Call", NULL, 0, 0 },
+	{ "Dates", "Date", NULL, 0, 0 },
+};
+
+static DBusConnection *bus = NULL;
+static struct _query *queries = NULL;
+static int last_query = 0;
+static struct _delayed *delayed = NULL;
+static int latency = 0;
+static int event_interval = 0;
+static int sms_reference = 0;
+
+/* for sorting query matches */
+static struct _domain *sort_domain = NULL;
+static const char *sort_field = NULL;
+static int sort_desc = 0;
+
+static long long
+_now()
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return (long long) tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+static struct _field *
+_entry_field(struct _entry *entry, const char *name)
+{
+	int i;
+
+	for (i = 0; i < entry->count; i++) {
+		if (!strcmp(entry->fields[i].name, name))
+			return &entry->fields[i];
+	}
+	return NULL;
+}
+
+static void
+_entry_set(struct _entry *entry, const char *name, int type,
+	   const char *s, int i)
+{
+	struct _field *field = _entry_field(entry, name);
+
+	if (!field) {
+		entry->fields = realloc(entry->fields,
+					(entry->count + 1) * sizeof(*field));
+		field = &entry->fields[entry->count++];
+		field->name = strdup(name);
+	}
+	else {
+		free(field->s);
+	}
+	field->type = type;
+	field->s = (s) ? strdup(s) : NULL;
+	field->i = i;
+}
+
+static void
+_entry_set_string(struct _entry *entry, const char *name, const char *value)
+{
+	_entry_set(entry, name, DBUS_TYPE_STRING, value, 0);
+}
+
+static void
+_entry_set_int(struct _entry *entry, const char *name, int value)
+{
+	_entry_set(entry, name, DBUS_TYPE_INT32, NULL, value);
+}
+
+static void
+_entry_set_boolean(struct _entry *entry, const char *name, int value)
+{
+	_entry_set(entry, name, DBUS_TYPE_BOOLEAN, NULL, value != 0);
+}
+
+static void
+_entry_clear(struct _entry *entry)
+{
+	int i;
+
+	for (i = 0; i < entry->count; i++) {
+		free(entry->fields[i].name);
+		free(entry->fields[i].s);
+	}
+	free(entry->fields);
+	entry->fields = NULL;
+	entry->count = 0;
+}
+
+static char *
+_entry_path(int domain, int index)
+{
+	char *path = malloc(128);
+
+	snprintf(path, 128, PIM_PATH "/%s/%d", domains[domain].name, index);
+	return path;
+}
+
+static struct _entry *
+_domain_add(int domain)
+{
+	struct _domain *d = &domains[domain];
+	struct _entry *entry;
+	char *path;
+
+	if (d->count == d->size) {
+		d->size = (d->size) ? d->size * 2 : 64;
+		d->entries = realloc(d->entries, d->size * sizeof(*entry));
+	}
+	entry = &d->entries[d->count];
+	memset(entry, 0, sizeof(*entry));
+	path = _entry_path(domain, d->count);
+	_entry_set_string(entry, "Path", path);
+	free(path);
+	d->count++;
+	return entry;
+}
+
+static void
+_phone_number(int index, char *buf, size_t size)
+{
+	snprintf(buf, size, "+49170%07d", index);
+}
+
+static void
+_generate(int contacts, int messages, int calls, int dates)
+{
+	int i;
+	int now = time(NULL);
+	char buf[64];
+	struct _entry *e;
+
+	for (i = 0; i < contacts; i++) {
+		e = _domain_add(DOMAIN_CONTACTS);
+		/* not in index order, so sorting has something to do */
+		snprintf(buf, sizeof(buf), "First%d", (i * 7919) % contacts);
+		_entry_set_string(e, "Name", buf);
+		snprintf(buf, sizeof(buf), "Last%d", (i * 104729) % contacts);
+		_entry_set_string(e, "Surname", buf);
+		_phone_number(i, buf, sizeof(buf));
+		_entry_set_string(e, "Phone", buf);
+	}
+	for (i = 0; i < messages; i++) {
+		e = _domain_add(DOMAIN_MESSAGES);
+		_phone_number((contacts) ? i % contacts : i, buf, sizeof(buf));
+		_entry_set_string(e, "Peer", buf);
+		_entry_set_string(e, "Direction", (i % 2) ? "out" : "in");
+		snprintf(buf, sizeof(buf), "Synthetic message number %d", i);
+		_entry_set_string(e, "Content", buf);
+		_entry_set_string(e, "Source", "SMS");
+		_entry_set_int(e, "Timestamp", now - i * 60);
+		_entry_set_boolean(e, "New", i % 2 == 0 && i % 10 == 0);
+	}
+	for (i = 0; i < calls; i++) {
+		e = _domain_add(DOMAIN_CALLS);
+		_phone_number((contacts) ? i % contacts : i, buf, sizeof(buf));
+		_entry_set_string(e, "Peer", buf);
+		_entry_set_string(e, "Direction", (i % 2) ? "out" : "in");
+		_entry_set_boolean(e, "Answered", i % 3 != 0);
+		_entry_set_boolean(e, "New", i % 2 == 0 && i % 3 == 0);
+		_entry_set_int(e, "Timestamp", now - i * 300);
+		_entry_set_int(e, "Duration", (i % 3) ? i % 600 : 0);
+	}
+	for (i = 0; i < dates; i++) {
+		e = _domain_add(DOMAIN_DATES);
+		snprintf(buf, sizeof(buf), "Synthetic date %d", i);
+		_entry_set_string(e, "Title", buf);
+		_entry_set_int(e, "Begin", now + i * 3600);
+		_entry_set_int(e, "End", now + i * 3600 + 1800);
+	}
+}
+
+/* reads an a{sv} into the entry, only string, int and boolean values */
+static void
+_read_fields(DBusMessageIter *array, struct _entry *entry)
+{
+	DBusMessageIter dict, variant;
+	const char *name, *s;
+	dbus_int32_t i;
+	dbus_bool_t b;
+
+	while (dbus_message_iter_get_arg_type(array) == DBUS_TYPE_DICT_ENTRY) {
+		dbus_message_iter_recurse(array, &dict);
+		dbus_message_iter_get_basic(&dict, &name);
+		dbus_message_iter_next(&dict);
+		if (dbus_message_iter_get_arg_type(&dict) != DBUS_TYPE_VARIANT) {
+			dbus_message_iter_next(array);
+			continue;
+		}
+		dbus_message_iter_recurse(&dict, &variant);
+		switch (dbus_message_iter_get_arg_type(&variant)) {
+		case DBUS_TYPE_STRING:
+		case DBUS_TYPE_OBJECT_PATH:
+			dbus_message_iter_get_basic(&variant, &s);
+			_entry_set_string(entry, name, s);
+			break;
+		case DBUS_TYPE_INT32:
+			dbus_message_iter_get_basic(&variant, &i);
+			_entry_set_int(entry, name, i);
+			break;
+		case DBUS_TYPE_BOOLEAN:
+			dbus_message_iter_get_basic(&variant, &b);
+			_entry_set_boolean(entry, name, b);
+			break;
+		default:
+			break;
+		}
+		dbus_message_iter_next(array);
+	}
+}
+
+static void
+_append_field(DBusMessageIter *array, const struct _field *field)
+{
+	DBusMessageIter dict, variant;
+	dbus_bool_t b;
+	dbus_int32_t i;
+	char sig[2] = { (char) field->type, 0 };
+
+	dbus_message_iter_open_container(array, DBUS_TYPE_DICT_ENTRY, NULL, &dict);
+	dbus_message_iter_append_basic(&dict, DBUS_TYPE_STRING, &field->name);
+	dbus_message_iter_open_container(&dict, DBUS_TYPE_VARIANT, sig, &variant);
+	switch (field->type) {
+	case DBUS_TYPE_STRING:
+		dbus_message_iter_append_basic(&variant, DBUS_TYPE_STRING, &field->s);
+		break;
+	case DBUS_TYPE_INT32:
+		i = field->i;
+		dbus_message_iter_append_basic(&variant, DBUS_TYPE_INT32, &i);
+		break;
+	default:
+		b = field->i;
+		dbus_message_iter_append_basic(&variant, DBUS_TYPE_BOOLEAN, &b);
+		break;
+	}
+	dbus_message_iter_close_container(&dict, &variant);
+	dbus_message_iter_close_container(array, &dict);
+}
+
+/* appends an a{sv} of the entry - only the fields listed, if any */
+static void
+_append_entry(DBusMessageIter *iter, struct _entry *entry, char **only)
+{
+	DBusMessageIter array;
+	int i, j;
+
+	dbus_message_iter_open_container(iter, DBUS_TYPE_ARRAY, "{sv}", &array);
+	for (i = 0; i < entry->count; i++) {
+		if (only) {
+			for (j = 0; only[j]; j++) {
+				if (!strcmp(only[j], entry->fields[i].name))
+					break;
+			}
+			if (!only[j])
+				continue;
+		}
+		_append_field(&array, &entry->fields[i]);
+	}
+	dbus_message_iter_close_container(iter, &array);
+}
+
+static void
+_reply(DBusMessage *reply)
+{
+	struct _delayed *d, **p;
+
+	if (!reply)
+		return;
+	if (latency <= 0) {
+		dbus_connection_send(bus, reply, NULL);
+		dbus_message_unref(reply);
+		return;
+	}
+	d = malloc(sizeof(*d));
+	d->due = _now() + latency;
+	d->reply = reply;
+	d->next = NULL;
+	/* same latency for all, so appending keeps them ordered */
+	for (p = &delayed; *p; p = &(*p)->next)
+		;
+	*p = d;
+}
+
+static void
+_reply_error(DBusMessage *msg, const char *name, const char *text)
+{
+	_reply(dbus_message_new_error(msg, name, text));
+}
+
+static void
+_signal_path(const char *path, const char *iface, const char *name,
+	     const char *arg)
+{
+	DBusMessage *signal = dbus_message_new_signal(path, iface, name);
+
+	if (arg) {
+		dbus_message_append_args(signal, DBUS_TYPE_STRING, &arg,
+					 DBUS_TYPE_INVALID);
+	}
+	dbus_connection_send(bus, signal, NULL);
+	dbus_message_unref(signal);
+}
+
+static void
+_signal_int(const char *path, const char *iface, const char *name, int value)
+{
+	DBusMessage *signal = dbus_message_new_signal(path, iface, name);
+	dbus_int32_t i = value;
+
+	dbus_message_append_args(signal, DBUS_TYPE_INT32, &i, DBUS_TYPE_INVALID);
+	dbus_connection_send(bus, signal, NULL);
+	dbus_message_unref(signal);
+}
+
+static int
+_unread_messages()
+{
+	int i, count = 0;
+	struct _entry *e;
+	struct _field *f;
+
+	for (i = 0; i < domains[DOMAIN_MESSAGES].count; i++) {
+		e = &domains[DOMAIN_MESSAGES].entries[i];
+		f = _entry_field(e, "New");
+		if (!e->deleted && f && f->i)
+			count++;
+	}
+	return count;
+}
+
+/* like opimd, $phonenumber matches any of the phone fields */
+static int
+_entry_has_number(struct _entry *entry, const char *number)
+{
+	int i;
+
+	for (i = 0; i < entry->count; i++) {
+		if (entry->fields[i].type == DBUS_TYPE_STRING &&
+				strstr(entry->fields[i].name, "hone") &&
+				!strcmp(entry->fields[i].s, number))
+			return 1;
+	}
+	return 0;
+}
+
+static int
+_entry_matches(struct _entry *entry, struct _entry *options)
+{
+	int i;
+	struct _field *want, *have;
+
+	if (entry->deleted)
+		return 0;
+	for (i = 0; i < options->count; i++) {
+		want = &options->fields[i];
+		if (want->name[0] == '_')
+			continue;
+		if (!strcmp(want->name, "$phonenumber")) {
+			if (want->type != DBUS_TYPE_STRING ||
+					!_entry_has_number(entry, want->s))
+				return 0;
+			continue;
+		}
+		have = _entry_field(entry, want->name);
+		if (!have)
+			return 0;
+		if (want->type == DBUS_TYPE_STRING) {
+			if (have->type != DBUS_TYPE_STRING ||
+					!strstr(have->s, want->s))
+				return 0;
+		}
+		else if (have->type == DBUS_TYPE_STRING || have->i != want->i) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static int
+_compare_matches(const void *a, const void *b)
+{
+	struct _field *fa, *fb;
+	int ret;
+
+	fa = _entry_field(&sort_domain->entries[*(const int *) a], sort_field);
+	fb = _entry_field(&sort_domain->entries[*(const int *) b], sort_field);
+	if (!fa || !fb)
+		ret = (fa != NULL) - (fb != NULL);
+	else if (fa->type == DBUS_TYPE_STRING && fb->type == DBUS_TYPE_STRING)
+		ret = strcmp(fa->s, fb->s);
+	else
+		ret = (fa->i > fb->i) - (fa->i < fb->i);
+	return (sort_desc) ? -ret : ret;
+}
+
+static struct _query *
+_query_find(int domain, int id)
+{
+	struct _query *q;
+
+	for (q = queries; q; q = q->next) {
+		if (q->domain == domain && q->id == id)
+			return q;
+	}
+	return NULL;
+}
+
+static void
+_query_dispose(struct _query *query)
+{
+	struct _query **p;
+
+	for (p = &queries; *p; p = &(*p)->next) {
+		if (*p == query) {
+			*p = query->next;
+			break;
+		}
+	}
+	free(query->matches);
+	free(query);
+}
+
+static void
+_collection_query(DBusMessage *msg, int domain)
+{
+	DBusMessageIter iter, array;
+	struct _entry options = { 0, 0, NULL };
+	struct _domain *d = &domains[domain];
+	struct _query *query;
+	struct _field *f;
+	DBusMessage *reply;
+	char path[128];
+	const char *p = path;
+	int i, start = 0, limit = -1;
+
+	dbus_message_iter_init(msg, &iter);
+	if (dbus_message_iter_get_arg_type(&iter) == DBUS_TYPE_ARRAY) {
+		dbus_message_iter_recurse(&iter, &array);
+		_read_fields(&array, &options);
+	}
+
+	query = calloc(1, sizeof(*query));
+	query->id = last_query++;
+	query->domain = domain;
+	query->matches = malloc((d->count + 1) * sizeof(int));
+	for (i = 0; i < d->count; i++) {
+		if (_entry_matches(&d->entries[i], &options))
+			query->matches[query->count++] = i;
+	}
+
+	f = _entry_field(&options, "_sortby");
+	if (f && f->s && *f->s) {
+		sort_domain = d;
+		sort_field = f->s;
+		f = _entry_field(&options, "_sortdesc");
+		sort_desc = (f) ? f->i : 0;
+		qsort(query->matches, query->count, sizeof(int),
+		      _compare_matches);
+	}
+	f = _entry_field(&options, "_limit_start");
+	if (f && f->i > 0)
+		start = (f->i < query->count) ? f->i : query->count;
+	f = _entry_field(&options, "_limit");
+	if (f && f->i >= 0)
+		limit = f->i;
+	if (start > 0) {
+		memmove(query->matches, query->matches + start,
+			(query->count - start) * sizeof(int));
+		query->count -= start;
+	}
+	if (limit >= 0 && limit < query->count)
+		query->count = limit;
+	_entry_clear(&options);
+
+	query->next = queries;
+	queries = query;
+
+	snprintf(path, sizeof(path), PIM_PATH "/%s/Queries/%d",
+		 d->name, query->id);
+	reply = dbus_message_new_method_return(msg);
+	dbus_message_append_args(reply, DBUS_TYPE_STRING, &p, DBUS_TYPE_INVALID);
+	_reply(reply);
+}
+
+static void
+_collection_add(DBusMessage *msg, int domain)
+{
+	DBusMessageIter iter, array;
+	struct _entry *entry;
+	struct _field *path;
+	DBusMessage *reply;
+	char iface[64], signal[64], collection[64];
+
+	entry = _domain_add(domain);
+	dbus_message_iter_init(msg, &iter);
+	if (dbus_message_iter_get_arg_type(&iter) == DBUS_TYPE_ARRAY) {
+		dbus_message_iter_recurse(&iter, &array);
+		_read_fields(&array, entry);
+	}
+	path = _entry_field(entry, "Path");
+
+	reply = dbus_message_new_method_return(msg);
+	dbus_message_append_args(reply, DBUS_TYPE_STRING, &path->s,
+				 DBUS_TYPE_INVALID);
+	_reply(reply);
+
+	snprintf(iface, sizeof(iface), PIM_IFACE ".%s", domains[domain].name);
+	snprintf(collection, sizeof(collection), PIM_PATH "/%s",
+		 domains[domain].name);
+	snprintf(signal, sizeof(signal), "New%s", domains[domain].single);
+	_signal_path(collection, iface, signal, path->s);
+	if (domain == DOMAIN_MESSAGES) {
+		_signal_int(PIM_PATH "/Messages", iface, "UnreadMessages",
+			    _unread_messages());
+	}
+}
+
+static void
+_query_method(DBusMessage *msg, struct _query *query, const char *method)
+{
+	DBusMessageIter iter, array;
+	DBusMessage *reply;
+	struct _domain *d = &domains[query->domain];
+	dbus_int32_t n = 0;
+	int i;
+
+	if (!strcmp(method, "Dispose")) {
+		_query_dispose(query);
+		_reply(dbus_message_new_method_return(msg));
+		return;
+	}
+	if (!strcmp(method, "Rewind")) {
+		query->pos = 0;
+		_reply(dbus_message_new_method_return(msg));
+		return;
+	}
+
+	reply = dbus_message_new_method_return(msg);
+	dbus_message_get_args(msg, NULL, DBUS_TYPE_INT32, &n, DBUS_TYPE_INVALID);
+	dbus_message_iter_init_append(reply, &iter);
+	if (!strcmp(method, "GetResultCount")) {
+		n = query->count;
+		dbus_message_iter_append_basic(&iter, DBUS_TYPE_INT32, &n);
+	}
+	else if (!strcmp(method, "Skip")) {
+		query->pos += n;
+		if (query->pos > query->count)
+			query->pos = query->count;
+	}
+	else if (!strcmp(method, "GetResult")) {
+		if (query->pos >= query->count) {
+			dbus_message_unref(reply);
+			_reply_error(msg, "org.freesmartphone.PIM.NoMoreResults",
+				     "No more results");
+			return;
+		}
+		_append_entry(&iter, &d->entries[query->matches[query->pos++]],
+			      NULL);
+	}
+	else if (!strcmp(method, "GetMultipleResults")) {
+		/* -1 for all of the rest */
+		if (n < 0 || n > query->count - query->pos)
+			n = query->count - query->pos;
+		dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY,
+						 "a{sv}", &array);
+		for (i = 0; i < n; i++) {
+			_append_entry(&array,
+				&d->entries[query->matches[query->pos++]], NULL);
+		}
+		dbus_message_iter_close_container(&iter, &array);
+	}
+	else {
+		dbus_message_unref(reply);
+		_reply_error(msg, DBUS_ERROR_UNKNOWN_METHOD, method);
+		return;
+	}
+	_reply(reply);
+}
+
+static void
+_entry_method(DBusMessage *msg, int domain, int index, const char *method)
+{
+	DBusMessageIter iter, array;
+	DBusMessage *reply, *signal;
+	struct _entry *entry = &domains[domain].entries[index];
+	struct _entry changes = { 0, 0, NULL };
+	struct _field *path = _entry_field(entry, "Path");
+	const char *fields;
+	char **only;
+	char iface[64], single_iface[64], name[64], collection[64];
+	int i;
+
+	snprintf(iface, sizeof(iface), PIM_IFACE ".%s", domains[domain].name);
+	snprintf(collection, sizeof(collection), PIM_PATH "/%s",
+		 domains[domain].name);
+	snprintf(single_iface, sizeof(single_iface), PIM_IFACE ".%s",
+		 domains[domain].single);
+
+	if (!strcmp(method, "GetContent")) {
+		reply = dbus_message_new_method_return(msg);
+		dbus_message_iter_init_append(reply, &iter);
+		_append_entry(&iter, entry, NULL);
+		_reply(reply);
+	}
+	else if (!strcmp(method, "GetMultipleFields")) {
+		fields = "";
+		dbus_message_get_args(msg, NULL, DBUS_TYPE_STRING, &fields,
+				      DBUS_TYPE_INVALID);
+		only = calloc(strlen(fields) + 2, sizeof(char *));
+		only[0] = strdup(fields);
+		for (i = 0; only[i] && (only[i + 1] = strchr(only[i], ',')); i++) {
+			*only[i + 1]++ = 0;
+			while (*only[i + 1] == ' ')
+				only[i + 1]++;
+		}
+		reply = dbus_message_new_method_return(msg);
+		dbus_message_iter_init_append(reply, &iter);
+		_append_entry(&iter, entry, only);
+		_reply(reply);
+		free(only[0]);
+		free(only);
+	}
+	else if (!strcmp(method, "Update")) {
+		dbus_message_iter_init(msg, &iter);
+		if (dbus_message_iter_get_arg_type(&iter) == DBUS_TYPE_ARRAY) {
+			dbus_message_iter_recurse(&iter, &array);
+			_read_fields(&array, &changes);
+		}
+		for (i = 0; i < changes.count; i++) {
+			_entry_set(entry, changes.fields[i].name,
+				   changes.fields[i].type, changes.fields[i].s,
+				   changes.fields[i].i);
+		}
+		_reply(dbus_message_new_method_return(msg));
+
+		snprintf(name, sizeof(name), "Updated%s", domains[domain].single);
+		signal = dbus_message_new_signal(collection, iface, name);
+		dbus_message_iter_init_append(signal, &iter);
+		dbus_message_iter_append_basic(&iter, DBUS_TYPE_STRING, &path->s);
+		_append_entry(&iter, &changes, NULL);
+		dbus_connection_send(bus, signal, NULL);
+		dbus_message_unref(signal);
+
+		snprintf(name, sizeof(name), "%sUpdated", domains[domain].single);
+		signal = dbus_message_new_signal(path->s, single_iface, name);
+		dbus_message_iter_init_append(signal, &iter);
+		_append_entry(&iter, &changes, NULL);
+		dbus_connection_send(bus, signal, NULL);
+		dbus_message_unref(signal);
+		_entry_clear(&changes);
+
+		if (domain == DOMAIN_MESSAGES) {
+			_signal_int(PIM_PATH "/Messages", iface, "UnreadMessages",
+				    _unread_messages());
+		}
+	}
+	else if (!strcmp(method, "Delete")) {
+		entry->deleted = 1;
+		_reply(dbus_message_new_method_return(msg));
+		snprintf(name, sizeof(name), "Deleted%s", domains[domain].single);
+		_signal_path(collection, iface, name, path->s);
+		snprintf(name, sizeof(name), "%sDeleted", domains[domain].single);
+		_signal_path(path->s, single_iface, name, NULL);
+	}
+	else {
+		_reply_error(msg, DBUS_ERROR_UNKNOWN_METHOD, method);
+	}
+}
+
+static void
+_pim_message(DBusMessage *msg, const char *path, const char *method)
+{
+	int domain, id;
+	const char *rest;
+	size_t len;
+	DBusMessage *reply;
+	dbus_int32_t n;
+
+	for (domain = 0; domain < DOMAINS; domain++) {
+		len = strlen(domains[domain].name);
+		if (!strncmp(path, domains[domain].name, len) &&
+				(path[len] == '/' || !path[len]))
+			break;
+	}
+	if (domain == DOMAINS) {
+		_reply_error(msg, DBUS_ERROR_UNKNOWN_OBJECT, path);
+		return;
+	}
+	rest = path + len;
+
+	if (!*rest) {
+		if (!strcmp(method, "Query")) {
+			_collection_query(msg, domain);
+		}
+		else if (!strcmp(method, "Add")) {
+			_collection_add(msg, domain);
+		}
+		else if (!strcmp(method, "GetUnreadMessages") ||
+				!strcmp(method, "GetNewMissedCalls")) {
+			n = (domain == DOMAIN_MESSAGES) ? _unread_messages() : 0;
+			reply = dbus_message_new_method_return(msg);
+			dbus_message_append_args(reply, DBUS_TYPE_INT32, &n,
+						 DBUS_TYPE_INVALID);
+			_reply(reply);
+		}
+		else {
+			_reply_error(msg, DBUS_ERROR_UNKNOWN_METHOD, method);
+		}
+		return;
+	}
+
+	if (sscanf(rest, "/Queries/%d", &id) == 1) {
+		struct _query *query = _query_find(domain, id);
+		if (!query) {
+			_reply_error(msg, "org.freesmartphone.PIM.NoSuchFile",
+				     "No such query");
+			return;
+		}
+		_query_method(msg, query, method);
+		return;
+	}
+	if (sscanf(rest, "/%d", &id) == 1 && id >= 0 &&
+			id < domains[domain].count &&
+			!domains[domain].entries[id].deleted) {
+		_entry_method(msg, domain, id, method);
+		return;
+	}
+	_reply_error(msg, "org.freesmartphone.PIM.NoSuchFile", "No such entry");
+}
+
+static void
+_append_network_status(DBusMessageIter *iter, int strength)
+{
+	struct _entry status = { 0, 0, NULL };
+
+	_entry_set_string(&status, "registration", "home");
+	_entry_set_string(&status, "mode", "automatic");
+	_entry_set_string(&status, "provider", "Mock Mobile");
+	_entry_set_string(&status, "display", "Mock Mobile");
+	_entry_set_string(&status, "code", "26201");
+	_entry_set_string(&status, "act", "GSM");
+	_entry_set_int(&status, "strength", strength);
+	_append_entry(iter, &status, NULL);
+	_entry_clear(&status);
+}
+
+static void
+_gsm_message(DBusMessage *msg, const char *iface, const char *method)
+{
+	DBusMessageIter iter;
+	DBusMessage *reply;
+	const char *number = NULL, *content = NULL, *s;
+	dbus_int32_t i;
+	char timestamp[32];
+
+	reply = dbus_message_new_method_return(msg);
+	dbus_message_iter_init_append(reply, &iter);
+	if (!strcmp(iface, "org.freesmartphone.GSM.SMS") &&
+			!strcmp(method, "SendTextMessage")) {
+		dbus_message_get_args(msg, NULL, DBUS_TYPE_STRING, &number,
+				      DBUS_TYPE_STRING, &content,
+				      DBUS_TYPE_INVALID);
+		i = ++sms_reference;
+		snprintf(timestamp, sizeof(timestamp), "%ld", (long) time(NULL));
+		s = timestamp;
+		dbus_message_iter_append_basic(&iter, DBUS_TYPE_INT32, &i);
+		dbus_message_iter_append_basic(&iter, DBUS_TYPE_STRING, &s);
+	}
+	else if (!strcmp(method, "GetStatus")) {
+		_append_network_status(&iter, 80);
+	}
+	else if (!strcmp(method, "GetSignalStrength")) {
+		i = 80;
+		dbus_message_iter_append_basic(&iter, DBUS_TYPE_INT32, &i);
+	}
+	else if (!strcmp(method, "GetAuthStatus")) {
+		s = "READY";
+		dbus_message_iter_append_basic(&iter, DBUS_TYPE_STRING, &s);
+	}
+	else if (!strcmp(method, "ListCalls")) {
+		DBusMessageIter array;
+		dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY,
+						 "(isa{sv})", &array);
+		dbus_message_iter_close_container(&iter, &array);
+	}
+	else {
+		dbus_message_unref(reply);
+		_reply_error(msg, DBUS_ERROR_UNKNOWN_METHOD, method);
+		return;
+	}
+	_reply(reply);
+}
+
+static void
+_usage_message(DBusMessage *msg, const char *method)
+{
+	DBusMessageIter iter, array;
+	DBusMessage *reply;
+	const char *resources[] = { "GSM", "Display", "CPU", NULL };
+	dbus_bool_t state = TRUE;
+	int i;
+
+	reply = dbus_message_new_method_return(msg);
+	dbus_message_iter_init_append(reply, &iter);
+	if (!strcmp(method, "ListResources")) {
+		dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, "s",
+						 &array);
+		for (i = 0; resources[i]; i++) {
+			dbus_message_iter_append_basic(&array, DBUS_TYPE_STRING,
+						       &resources[i]);
+		}
+		dbus_message_iter_close_container(&iter, &array);
+	}
+	else if (!strcmp(method, "GetResourceState")) {
+		dbus_message_iter_append_basic(&iter, DBUS_TYPE_BOOLEAN, &state);
+	}
+	else if (strcmp(method, "RequestResource") &&
+			strcmp(method, "ReleaseResource")) {
+		dbus_message_unref(reply);
+		_reply_error(msg, DBUS_ERROR_UNKNOWN_METHOD, method);
+		return;
+	}
+	_reply(reply);
+}
+
+static DBusHandlerResult
+_message_handler(DBusConnection *connection, DBusMessage *msg, void *data)
+{
+	(void) connection;
+	(void) data;
+	const char *path = dbus_message_get_path(msg);
+	const char *iface = dbus_message_get_interface(msg);
+	const char *method = dbus_message_get_member(msg);
+
+	if (dbus_message_get_type(msg) != DBUS_MESSAGE_TYPE_METHOD_CALL ||
+			!path || !method)
+		return DBUS_HANDLER_RESULT_NOT_YET_HANDLED;
+
+	if (!strncmp(path, PIM_PATH "/", strlen(PIM_PATH) + 1)) {
+		_pim_message(msg, path + strlen(PIM_PATH) + 1, method);
+	}
+	else if (!strcmp(path, GSM_PATH)) {
+		_gsm_message(msg, (iface) ? iface : "", method);
+	}
+	else if (!strcmp(path, USAGE_PATH)) {
+		_usage_message(msg, method);
+	}
+	else {
+		_reply_error(msg, DBUS_ERROR_UNKNOWN_OBJECT, path);
+	}
+	return DBUS_HANDLER_RESULT_HANDLED;
+}
+
+/* one of a rotating set of the signals the UI listens to */
+static void
+_event(int n)
+{
+	DBusMessage *signal;
+	DBusMessageIter iter;
+	struct _entry *entry, props = { 0, 0, NULL };
+	struct _field *path;
+	const char *s;
+	dbus_int32_t i;
+	dbus_bool_t b;
+	char buf[64];
+
+	switch (n % 4) {
+	case 0:
+		entry = _domain_add(DOMAIN_MESSAGES);
+		_phone_number(n, buf, sizeof(buf));
+		_entry_set_string(entry, "Peer", buf);
+		_entry_set_string(entry, "Direction", "in");
+		_entry_set_string(entry, "Content", "Incoming synthetic message");
+		_entry_set_string(entry, "Source", "SMS");
+		_entry_set_int(entry, "Timestamp", time(NULL));
+		_entry_set_boolean(entry, "New", 1);
+		path = _entry_field(entry, "Path");
+		_signal_path(PIM_PATH "/Messages", PIM_IFACE ".Messages", "NewMessage",
+			     path->s);
+		_signal_int(PIM_PATH "/Messages", PIM_IFACE ".Messages",
+			    "UnreadMessages", _unread_messages());
+		break;
+	case 1:
+		signal = dbus_message_new_signal(GSM_PATH,
+				"org.freesmartphone.GSM.Network", "Status");
+		dbus_message_iter_init_append(signal, &iter);
+		_append_network_status(&iter, 40 + n % 60);
+		dbus_connection_send(bus, signal, NULL);
+		dbus_message_unref(signal);
+		_signal_int(GSM_PATH, "org.freesmartphone.GSM.Network",
+			    "SignalStrength", 40 + n % 60);
+		break;
+	case 2:
+		signal = dbus_message_new_signal(USAGE_PATH,
+				"org.freesmartphone.Usage", "ResourceChanged");
+		dbus_message_iter_init_append(signal, &iter);
+		s = "GSM";
+		b = (n / 4) % 2;
+		dbus_message_iter_append_basic(&iter, DBUS_TYPE_STRING, &s);
+		dbus_message_iter_append_basic(&iter, DBUS_TYPE_BOOLEAN, &b);
+		_append_entry(&iter, &props, NULL);
+		dbus_connection_send(bus, signal, NULL);
+		dbus_message_unref(signal);
+		break;
+	case 3:
+		signal = dbus_message_new_signal(GSM_PATH,
+				"org.freesmartphone.GSM.Call", "CallStatus");
+		dbus_message_iter_init_append(signal, &iter);
+		i = 1;
+		s = ((n / 4) % 2) ? "release" : "incoming";
+		_phone_number(n, buf, sizeof(buf));
+		_entry_set_string(&props, "peer", buf);
+		dbus_message_iter_append_basic(&iter, DBUS_TYPE_INT32, &i);
+		dbus_message_iter_append_basic(&iter, DBUS_TYPE_STRING, &s);
+		_append_entry(&iter, &props, NULL);
+		dbus_connection_send(bus, signal, NULL);
+		dbus_message_unref(signal);
+		_entry_clear(&props);
+		break;
+	}
+}
+
+static void
+_usage(const char *name)
+{
+	fprintf(stderr,
+		"usage: %s [--bus ADDRESS] [--contacts N] [--messages N]\n"
+		"          [--calls N] [--dates N] [--latency MS] [--events MS]\n"
+		"  --bus       bus to serve on, the session bus by default\n"
+		"  --latency   delay of every reply\n"
+		"  --events    interval of synthetic signals, 0 for none\n",
+		name);
+	exit(1);
+}
+
+int
+main(int argc, char **argv)
+{
+	const char *address = NULL;
+	const char *names[] = { "org.freesmartphone.opimd",
+		"org.freesmartphone.ogsmd", "org.freesmartphone.ousaged", NULL };
+	int contacts = 1000, messages = 5000, calls = 1000, dates = 100;
+	int i, timeout, events = 0;
+	long long now, next_event = 0;
+	struct _delayed *d;
+	DBusError err;
+	DBusObjectPathVTable vtable = { NULL, _message_handler, NULL, NULL,
+					NULL, NULL };
+
+	for (i = 1; i < argc; i++) {
+		if (i + 1 >= argc)
+			_usage(argv[0]);
+		if (!strcmp(argv[i], "--bus"))
+			address = argv[++i];
+		else if (!strcmp(argv[i], "--contacts"))
+			contacts = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--messages"))
+			messages = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--calls"))
+			calls = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--dates"))
+			dates = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--latency"))
+			latency = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--events"))
+			event_interval = atoi(argv[++i]);
+		else
+			_usage(argv[0]);
+	}
+
+	dbus_error_init(&err);
+	if (address) {
+		bus = dbus_connection_open(address, &err);
+		if (bus && !dbus_bus_register(bus, &err)) {
+			dbus_connection_unref(bus);
+			bus = NULL;
+		}
+	}
+	else {
+		bus = dbus_bus_get(DBUS_BUS_SESSION, &err);
+	}
+	if (!bus) {
+		fprintf(stderr, "Can't connect to the bus: %s\n", err.message);
+		return 1;
+	}
+	dbus_connection_set_exit_on_disconnect(bus, TRUE);
+
+	_generate(contacts, messages, calls, dates);
+
+	for (i = 0; names[i]; i++) {
+		if (dbus_bus_request_name(bus, names[i],
+				DBUS_NAME_FLAG_DO_NOT_QUEUE, &err) !=
+				DBUS_REQUEST_NAME_REPLY_PRIMARY_OWNER) {
+			fprintf(stderr, "Can't own %s: %s\n", names[i],
+				(dbus_error_is_set(&err)) ? err.message : "taken");
+			return 1;
+		}
+	}
+	dbus_connection_register_fallback(bus, "/", &vtable, NULL);
+	printf("Serving %d contacts, %d messages, %d calls, %d dates\n",
+	       contacts, messages, calls, dates);
+	fflush(stdout);
+
+	if (event_interval > 0)
+		next_event = _now() + event_interval;
+	for (;;) {
+		now = _now();
+		timeout = 1000;
+		if (delayed && delayed->due - now < timeout)
+			timeout = delayed->due - now;
+		if (event_interval > 0 && next_event - now < timeout)
+			timeout = next_event - now;
+		if (timeout < 0)
+			timeout = 0;
+		if (!dbus_connection_read_write_dispatch(bus, timeout))
+			break;
+		/* drain what is queued without waiting again */
+		while (dbus_connection_dispatch(bus) == DBUS_DISPATCH_DATA_REMAINS)
+			;
+
+		now = _now();
+		while (delayed && delayed->due <= now) {
+			d = delayed;
+			delayed = d->next;
+			dbus_connection_send(bus, d->reply, NULL);
+			dbus_message_unref(d->reply);
+			free(d);
+		}
+		if (event_interval > 0 && next_event <= now) {
+			_event(events++);
+			next_event = now + event_interval;
+		}
+	}
+	return 0;
+}
@@ -21,13 +21,53 @@
 
 
 #include <stdlib.h>
+#include <string.h>
 #include <glib.h>
 #include <glib-object.h>
+#include "helpers.h"
+
+/* freed GValues are kept for reuse - queries, contacts and messages
+ * create and drop lots of them */
+#define GVALUE_POOL_MAX 512
+
+union _gvalue_slot {
+	union _gvalue_slot *next;
+	GValue value;
+};
+
+G_LOCK_DEFINE_STATIC(gvalue_pool);
+static union _gvalue_slot *gvalue_pool = NULL;
+static guint gvalue_pool_size = 0;
+static guint gvalue_pool_hits = 0;
+static guint gvalue_pool_misses = 0;
+
+static GValue *
+_helpers_gvalue_alloc()
+{
+	union _gvalue_slot *slot;
+
+	G_LOCK(gvalue_pool);
+	slot = gvalue_pool;
+	if (slot) {
+		gvalue_pool = slot->next;
+		gvalue_pool_size--;
+		gvalue_pool_hits++;
+	}
+	else {
+		gvalue_pool_misses++;
+	}
+	G_UNLOCK(gvalue_pool);
+
+	if (!slot)
+		return calloc(1, sizeof(union _gvalue_slot));
+	memset(slot, 0, sizeof(*slot));
+	return &slot->value;
+}
 
 GValue *
 _helpers_new_gvalue_string(const char *value)
 {
-	GValue *val = calloc(1, sizeof(GValue));
+	GValue *val = _helpers_gvalue_alloc();
 	if (!val) {
 		return NULL;
 	}
@@ -40,7 +80,7 @@ _helpers_new_gvalue_string(const char *value)
 GValue *
 _helpers_new_gvalue_int(int value)
 {
-	GValue *val = calloc(1, sizeof(GValue));
+	GValue *val = _helpers_gvalue_alloc();
 	if (!val) {
 		return NULL;
 	}
@@ -53,7 +93,7 @@ _helpers_new_gvalue_int(int value)
 GValue *
 _helpers_new_gvalue_boolean(int value)
 {
-	GValue *val = calloc(1, sizeof(GValue));
+	GValue *val = _helpers_gvalue_alloc();
 	if (!val) {
 		return NULL;
 	}
@@ -63,10 +103,83 @@ _helpers_new_gvalue_boolean(int value)
 	return val;
 }
 
+GValue *
+_helpers_new_gvalue_copy(const GValue *value)
+{
+	GValue *val = _helpers_gvalue_alloc();
+	if (!val) {
+		return NULL;
+	}
+	g_value_init(val, G_VALUE_TYPE(value));
+	g_value_copy(value, val);
+
+	return val;
+}
+
 void
 _helpers_free_gvalue(gpointer val)
 {
 	GValue *value = (GValue *)val;
+	union _gvalue_slot *slot = (union _gvalue_slot *)val;
+
 	g_value_unset(value);
-	g_free(value);
+
+	G_LOCK(gvalue_pool);
+	if (gvalue_pool_size < GVALUE_POOL_MAX) {
+		slot->next = gvalue_pool;
+		gvalue_pool = slot;
+		gvalue_pool_size++;
+		slot = NULL;
+	}
+	G_UNLOCK(gvalue_pool);
+
+	free(slot);
+}
+
+void
+_helpers_gvalue_pool_clear()
+{
+	union _gvalue_slot *slot;
+
+	G_LOCK(gvalue_pool);
+	while (gvalue_pool) {
+		slot = gvalue_pool;
+		gvalue_pool = slot->next;
+		free(slot);
+	}
+	gvalue_pool_size = 0;
+	G_UNLOCK(gvalue_pool);
+}
+
+gpointer
+_helpers_field(const char *name)
+{
+	/* FIXME: the cast is a hack, interned strings are never changed */
+	return (gpointer) g_intern_static_string(name);
+}
+
+gpointer
+_helpers_field_intern(const char *name)
+{
+	return (gpointer) g_intern_string(name);
+}
+
+GHashTable *
+_helpers_new_field_table()
+{
+	return g_hash_table_new_full(g_direct_hash, g_direct_equal,
+				     NULL, _helpers_free_gvalue);
+}
+
+void
+phoneui_utils_gvalue_pool_stats_get(guint *hits, guint *misses, guint *pooled)
+{
+	G_LOCK(gvalue_pool);
+	if (hits)
+		*hits = gvalue_pool_hits;
+	if (misses)
+		*misses = gvalue_pool_misses;
+	if (pooled)
+		*pooled = gvalue_pool_size;
+	G_UNLOCK(gvalue_pool);
 }
@@ -27,6 +27,17 @@
 GValue *_helpers_new_gvalue_string(const char *value);
 GValue *_helpers_new_gvalue_int(int value);
 GValue *_helpers_new_gvalue_boolean(gboolean value);
+GValue *_helpers_new_gvalue_copy(const GValue *value);
+/* only for GValues of the _helpers_new_gvalue_* functions or plain
+ * malloc'ed ones - they go back to a pool for reuse */
 void _helpers_free_gvalue(gpointer value);
+void _helpers_gvalue_pool_clear();
+
+/* PIM field names as table keys: interned, so tables made with
+ * _helpers_new_field_table hash and compare them by pointer and
+ * never copy or free them */
+gpointer _helpers_field(const char *name);
+gpointer _helpers_field_intern(const char *name);
+GHashTable *_helpers_new_field_table();
 
 #endif
@@ -0,0 +1,185 @@
+/*
+ *  Copyright (C) 2026
+ *      Authors (alphabetical) :
+ *		agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include "phoneui.h"
+#include "latency.h"
+
+/* the last LATENCY_SAMPLES samples of each operation are kept */
+#define LATENCY_SAMPLES 1024
+
+struct _latency_op {
+	char *name;
+	guint count;
+	gdouble samples[LATENCY_SAMPLES];
+};
+
+static gboolean _enabled = FALSE;
+static GTimer *_timer = NULL;
+/* operation name -> struct _latency_op */
+static GHashTable *_ops = NULL;
+
+static void
+_latency_op_free(gpointer data)
+{
+	struct _latency_op *op = data;
+
+	free(op->name);
+	free(op);
+}
+
+void
+_latency_load_config(GKeyFile *keyfile)
+{
+	phoneui_latency_enable(g_key_file_get_boolean(keyfile, "phoneui",
+						      "latency_stats", NULL));
+}
+
+gdouble
+_latency_begin()
+{
+	if (!_enabled)
+		return -1;
+	return g_timer_elapsed(_timer, NULL);
+}
+
+void
+_latency_end(gdouble start, const char *op, int n)
+{
+	gdouble elapsed;
+	struct _latency_op *o;
+
+	/* got enabled while the operation was running */
+	if (!_enabled || start < 0 || n <= 0)
+		return;
+
+	elapsed = (g_timer_elapsed(_timer, NULL) - start) * 1000 / n;
+	o = g_hash_table_lookup(_ops, op);
+	if (!o) {
+		o = calloc(1, sizeof(*o));
+		if (!o)
+			return;
+		o->name = strdup(op);
+		g_hash_table_insert(_ops, o->name, o);
+	}
+	o->samples[o->count++ % LATENCY_SAMPLES] = elapsed;
+}
+
+static int
+_compare_samples(const void *a, const void *b)
+{
+	gdouble x = *(const gdouble *) a;
+	gdouble y = *(const gdouble *) b;
+
+	return (x > y) - (x < y);
+}
+
+/* sorted copy of the kept samples, returns their number */
+static guint
+_latency_sorted(struct _latency_op *o, gdouble *sorted)
+{
+	guint len = MIN(o->count, LATENCY_SAMPLES);
+
+	memcpy(sorted, o->samples, len * sizeof(gdouble));
+	qsort(sorted, len, sizeof(gdouble), _compare_samples);
+	return len;
+}
+
+static gdouble
+_percentile(gdouble *sorted, guint len, int percentile)
+{
+	guint i = (len * percentile + 99) / 100;
+
+	return sorted[(i > 0) ? i - 1 : 0];
+}
+
+void
+phoneui_latency_enable(gboolean enable)
+{
+	_enabled = enable;
+	if (!_enabled || _timer)
+		return;
+
+	_timer = g_timer_new();
+	_ops = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+				     _latency_op_free);
+}
+
+void
+phoneui_latency_reset()
+{
+	if (_ops)
+		g_hash_table_remove_all(_ops);
+}
+
+double
+phoneui_latency_percentile_get(const char *op, int percentile)
+{
+	guint len;
+	gdouble ret;
+	gdouble *sorted;
+	struct _latency_op *o;
+
+	if (!_ops || !op || percentile < 0 || percentile > 100)
+		return -1;
+	o = g_hash_table_lookup(_ops, op);
+	if (!o || !o->count)
+		return -1;
+
+	sorted = malloc(LATENCY_SAMPLES * sizeof(gdouble));
+	if (!sorted)
+		return -1;
+	len = _latency_sorted(o, sorted);
+	ret = _percentile(sorted, len, percentile);
+	free(sorted);
+	return ret;
+}
+
+void
+phoneui_latency_dump()
+{
+	guint len;
+	gdouble *sorted;
+	GHashTableIter iter;
+	gpointer _key, _val;
+	struct _latency_op *o;
+
+	if (!_ops || !g_hash_table_size(_ops)) {
+		g_message("Latency: no samples recorded");
+		return;
+	}
+
+	sorted = malloc(LATENCY_SAMPLES * sizeof(gdouble));
+	if (!sorted)
+		return;
+	g_hash_table_iter_init(&iter, _ops);
+	while (g_hash_table_iter_next(&iter, &_key, &_val)) {
+		o = _val;
+		len = _latency_sorted(o, sorted);
+		g_message("Latency: %-28s %6u samples  p50 %8.2f  p90 %8.2f  "
+			  "p99 %8.2f  max %8.2f ms", o->name, o->count,
+			  _percentile(sorted, len, 50),
+			  _percentile(sorted, len, 90),
+			  _percentile(sorted, len, 99), sorted[len - 1]);
+	}
+	free(sorted);
+}
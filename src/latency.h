@@ -0,0 +1,33 @@
+/*
+ *  Copyright (C) 2026
+ *      Authors (alphabetical) :
+ *		agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ */
+
+#ifndef _LATENCY_H
+#define _LATENCY_H
+
+#include <glib.h>
+
+/* latency samples of the hot paths, only taken while enabled: pass the
+ * value returned by begin to end, together with the operation name and
+ * the number of operations the time covers */
+void _latency_load_config(GKeyFile *keyfile);
+gdouble _latency_begin();
+void _latency_end(gdouble start, const char *op, int n);
+
+#endif
@@ -0,0 +1,511 @@
+/*
+ *  Copyright (C) 2026
+ *      Authors (alphabetical) :
+ *		agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ */
+
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <glib-object.h>
+#include <phone-utils.h>
+#include "phoneui-info.h"
+#include "phoneui-utils.h"
+#include "phoneui-utils-messages.h"
+#include "helpers.h"
+#include "messages-index.h"
+
+enum _index_state {
+	INDEX_EMPTY,
+	INDEX_BUILDING,
+	INDEX_READY
+};
+
+struct _thread {
+	char *peer;
+	int count;
+	int unread;
+	GList *entries;
+	struct _message_entry *last;
+	/* content of the last message, NULL while it gets fetched */
+	GHashTable *last_message;
+};
+
+struct _message_entry {
+	char *path;
+	struct _thread *thread;
+	int timestamp;
+	gboolean unread;	/* New and incoming */
+};
+
+struct _threads_waiter {
+	void (*callback)(GError *, GHashTable **, int, gpointer);
+	gpointer data;
+};
+
+static enum _index_state _state = INDEX_EMPTY;
+static gboolean _changes_registered = FALSE;
+/* normalized peer -> struct _thread */
+static GHashTable *_threads = NULL;
+/* message path -> struct _message_entry */
+static GHashTable *_messages = NULL;
+/* struct _threads_waiter, for requests made while building */
+static GQueue *_waiters = NULL;
+/* paths of the messages that changed while building, the bulk results
+ * might predate those changes */
+static GHashTable *_changed = NULL;
+
+static void _message_get_callback(GError *error, GHashTable *message,
+				  gpointer data);
+
+static char *
+_normalize_number(const char *number)
+{
+	char *ret;
+
+	if (!number || !*number)
+		return NULL;
+	ret = strdup(number);
+	if (ret) {
+		phone_utils_remove_filler_chars(ret);
+	}
+	if (ret && !*ret) {
+		free(ret);
+		ret = NULL;
+	}
+	return ret;
+}
+
+static int
+_field_int(GHashTable *message, const char *field)
+{
+	const GValue *val = g_hash_table_lookup(message, field);
+
+	if (!val || !G_IS_VALUE(val))
+		return 0;
+	if (G_VALUE_HOLDS_INT(val))
+		return g_value_get_int(val);
+	if (G_VALUE_HOLDS_BOOLEAN(val))
+		return g_value_get_boolean(val);
+	return 0;
+}
+
+static gboolean
+_message_unread(GHashTable *message)
+{
+	const GValue *val;
+
+	if (!_field_int(message, "New"))
+		return FALSE;
+	/* sent ones can carry New as well */
+	val = g_hash_table_lookup(message, "Direction");
+	return val && G_VALUE_HOLDS_STRING(val) &&
+		!g_strcmp0(g_value_get_string(val), "in");
+}
+
+static struct _message_entry *
+_thread_newest(struct _thread *thread)
+{
+	GList *l;
+	struct _message_entry *e, *newest = NULL;
+
+	for (l = thread->entries; l; l = l->next) {
+		e = l->data;
+		if (!newest || e->timestamp >= newest->timestamp)
+			newest = e;
+	}
+	return newest;
+}
+
+/* the thread's last message went away - fetch the content of the one
+ * that took its place */
+static void
+_thread_last_fetch(struct _thread *thread, struct _message_entry *newest)
+{
+	thread->last = newest;
+	if (thread->last_message) {
+		g_hash_table_unref(thread->last_message);
+		thread->last_message = NULL;
+	}
+	phoneui_utils_message_get(newest->path, _message_get_callback,
+				  strdup(newest->path));
+}
+
+static void
+_thread_last_set(struct _thread *thread, struct _message_entry *entry,
+		 GHashTable *message)
+{
+	thread->last = entry;
+	if (thread->last_message) {
+		g_hash_table_unref(thread->last_message);
+	}
+	thread->last_message = g_hash_table_ref(message);
+}
+
+static void
+_thread_free(gpointer data)
+{
+	struct _thread *thread = data;
+
+	g_list_free(thread->entries);
+	if (thread->last_message) {
+		g_hash_table_unref(thread->last_message);
+	}
+	free(thread->peer);
+	free(thread);
+}
+
+static void
+_entry_free(gpointer data)
+{
+	struct _message_entry *entry = data;
+	struct _thread *thread = entry->thread;
+
+	thread->entries = g_list_remove(thread->entries, entry);
+	thread->count--;
+	if (entry->unread) {
+		thread->unread--;
+	}
+	if (thread->count == 0) {
+		g_hash_table_remove(_threads, thread->peer);
+	}
+	else if (thread->last == entry && _state != INDEX_EMPTY) {
+		/* the thread lost its last message - fall back to the
+		 * newest one left */
+		_thread_last_fetch(thread, _thread_newest(thread));
+	}
+	free(entry->path);
+	free(entry);
+}
+
+static void
+_index_message(const char *path, GHashTable *message)
+{
+	char *peer;
+	const GValue *val;
+	struct _thread *thread;
+	struct _message_entry *entry, *newest;
+	gboolean moved_back;
+
+	val = g_hash_table_lookup(message, "Peer");
+	peer = (val && G_VALUE_HOLDS_STRING(val)) ?
+		_normalize_number(g_value_get_string(val)) : NULL;
+
+	/* an update keeps its entry, unless the message changed threads */
+	entry = g_hash_table_lookup(_messages, path);
+	if (entry && (!peer || strcmp(entry->thread->peer, peer))) {
+		g_hash_table_remove(_messages, path);
+		entry = NULL;
+	}
+	if (!peer)
+		return;
+
+	thread = g_hash_table_lookup(_threads, peer);
+	if (thread) {
+		free(peer);
+	}
+	else {
+		thread = calloc(1, sizeof(*thread));
+		thread->peer = peer;
+		g_hash_table_insert(_threads, thread->peer, thread);
+	}
+
+	if (entry) {
+		if (entry->unread) {
+			thread->unread--;
+		}
+	}
+	else {
+		entry = malloc(sizeof(*entry));
+		entry->path = strdup(path);
+		entry->thread = thread;
+		g_hash_table_insert(_messages, entry->path, entry);
+		thread->entries = g_list_prepend(thread->entries, entry);
+		thread->count++;
+	}
+	moved_back = thread->last == entry &&
+		_field_int(message, "Timestamp") < entry->timestamp;
+	entry->timestamp = _field_int(message, "Timestamp");
+	entry->unread = _message_unread(message);
+	if (entry->unread) {
+		thread->unread++;
+	}
+
+	if (moved_back) {
+		/* only if the timestamp changed another one can be newer */
+		newest = _thread_newest(thread);
+		if (newest != entry) {
+			_thread_last_fetch(thread, newest);
+			return;
+		}
+	}
+	if (!thread->last || thread->last == entry ||
+	    entry->timestamp >= thread->last->timestamp) {
+		_thread_last_set(thread, entry, message);
+	}
+}
+
+static void
+_message_get_callback(GError *error, GHashTable *message, gpointer data)
+{
+	char *path = data;
+
+	if (error || !message || _state == INDEX_EMPTY) {
+		free(path);
+		return;
+	}
+	g_debug("Reindexing message %s", path);
+	_index_message(path, message);
+	free(path);
+}
+
+static void
+_message_changed_callback(void *data, const char *path,
+			  enum PhoneuiInfoChangeType type)
+{
+	(void) data;
+
+	if (_state == INDEX_EMPTY)
+		return;
+	if (_state == INDEX_BUILDING) {
+		g_hash_table_replace(_changed, g_strdup(path), NULL);
+		return;
+	}
+
+	switch (type) {
+	case PHONEUI_INFO_CHANGE_NEW:
+	case PHONEUI_INFO_CHANGE_UPDATE:
+		/* the update signal only carries the changed fields */
+		phoneui_utils_message_get(path, _message_get_callback,
+					  strdup(path));
+		break;
+	case PHONEUI_INFO_CHANGE_DELETE:
+		g_debug("Removing message %s from the index", path);
+		g_hash_table_remove(_messages, path);
+		break;
+	}
+}
+
+static void
+_value_copy(GHashTable *thread, GHashTable *message, const char *field)
+{
+	const GValue *val;
+
+	if (!message)
+		return;
+	val = g_hash_table_lookup(message, field);
+	if (val && G_IS_VALUE(val)) {
+		g_hash_table_insert(thread, (gpointer) field,
+				    _helpers_new_gvalue_copy(val));
+	}
+}
+
+static gint
+_compare_threads(gconstpointer a, gconstpointer b)
+{
+	int ta = _field_int(*(GHashTable **) a, "Timestamp");
+	int tb = _field_int(*(GHashTable **) b, "Timestamp");
+
+	/* newest first */
+	return (ta < tb) - (ta > tb);
+}
+
+static void
+_threads_deliver(void (*callback)(GError *, GHashTable **, int, gpointer),
+		 gpointer data)
+{
+	int i = 0, count;
+	GHashTable **threads;
+	GHashTable *t;
+	GHashTableIter iter;
+	gpointer _thread;
+	struct _thread *thread;
+
+	count = g_hash_table_size(_threads);
+	threads = g_malloc((count + 1) * sizeof(*threads));
+	g_hash_table_iter_init(&iter, _threads);
+	while (g_hash_table_iter_next(&iter, NULL, &_thread)) {
+		thread = _thread;
+		t = g_hash_table_new_full(g_str_hash, g_str_equal,
+					  NULL, _helpers_free_gvalue);
+		g_hash_table_insert(t, "Peer",
+				    _helpers_new_gvalue_string(thread->peer));
+		g_hash_table_insert(t, "Count",
+				    _helpers_new_gvalue_int(thread->count));
+		g_hash_table_insert(t, "Unread",
+				    _helpers_new_gvalue_int(thread->unread));
+		g_hash_table_insert(t, "Timestamp",
+				    _helpers_new_gvalue_int(thread->last->timestamp));
+		g_hash_table_insert(t, "Path",
+				    _helpers_new_gvalue_string(thread->last->path));
+		_value_copy(t, thread->last_message, "Content");
+		_value_copy(t, thread->last_message, "Direction");
+		threads[i++] = t;
+	}
+	threads[i] = NULL;
+	qsort(threads, count, sizeof(*threads), _compare_threads);
+
+	callback(NULL, threads, count, data);
+}
+
+static void
+_changed_replay()
+{
+	GHashTableIter iter;
+	gpointer path;
+
+	/* deleted ones stay removed as fetching them fails */
+	g_hash_table_iter_init(&iter, _changed);
+	while (g_hash_table_iter_next(&iter, &path, NULL)) {
+		g_debug("Message %s changed while building the index",
+			(char *) path);
+		g_hash_table_remove(_messages, path);
+		phoneui_utils_message_get(path, _message_get_callback,
+					  strdup(path));
+	}
+	g_hash_table_remove_all(_changed);
+}
+
+static void
+_messages_callback(GError *error, GHashTable **messages, int count,
+		   gpointer data)
+{
+	(void) data;
+	int i;
+	const GValue *tmp;
+	struct _threads_waiter *waiter;
+
+	if (_state != INDEX_BUILDING) {
+		/* got deinited meanwhile */
+		for (i = 0; messages && i < count; i++) {
+			g_hash_table_unref(messages[i]);
+		}
+		g_free(messages);
+		return;
+	}
+
+	if (error) {
+		g_warning("Failed building the messages index: (%d) %s",
+			  error->code, error->message);
+		_state = INDEX_EMPTY;
+		g_hash_table_remove_all(_changed);
+		while ((waiter = g_queue_pop_head(_waiters))) {
+			waiter->callback(error, NULL, 0, waiter->data);
+			free(waiter);
+		}
+		return;
+	}
+
+	for (i = 0; i < count; i++) {
+		tmp = g_hash_table_lookup(messages[i], "Path");
+		if (tmp) {
+			_index_message(g_value_get_string(tmp), messages[i]);
+		}
+		g_hash_table_unref(messages[i]);
+	}
+	g_free(messages);
+
+	g_debug("Messages index ready: %d messages in %d threads",
+		g_hash_table_size(_messages), g_hash_table_size(_threads));
+	_state = INDEX_READY;
+	_changed_replay();
+
+	while ((waiter = g_queue_pop_head(_waiters))) {
+		_threads_deliver(waiter->callback, waiter->data);
+		free(waiter);
+	}
+}
+
+static void
+_index_build()
+{
+	_state = INDEX_BUILDING;
+	if (!_threads) {
+		_threads = g_hash_table_new_full(g_str_hash, g_str_equal,
+						 NULL, _thread_free);
+		_messages = g_hash_table_new_full(g_str_hash, g_str_equal,
+						  NULL, _entry_free);
+		_waiters = g_queue_new();
+		_changed = g_hash_table_new_full(g_str_hash, g_str_equal,
+						 g_free, NULL);
+	}
+	if (!_changes_registered) {
+		phoneui_info_register_message_changes
+					(_message_changed_callback, NULL);
+		_changes_registered = TRUE;
+	}
+
+	g_debug("Building the messages index");
+	/* not messages_query_full, that one always filters on New */
+	phoneui_utils_messages_query(NULL, FALSE, FALSE, 0, -1, FALSE, NULL,
+				     _messages_callback, NULL);
+}
+
+int
+_messages_index_threads_get(void (*callback)(GError *, GHashTable **, int, gpointer),
+			    gpointer data)
+{
+	struct _threads_waiter *waiter;
+
+	if (!callback)
+		return 1;
+
+	if (_state == INDEX_READY) {
+		_threads_deliver(callback, data);
+		return 0;
+	}
+
+	if (_state == INDEX_EMPTY) {
+		_index_build();
+	}
+	waiter = malloc(sizeof(*waiter));
+	waiter->callback = callback;
+	waiter->data = data;
+	g_queue_push_tail(_waiters, waiter);
+	return 0;
+}
+
+void
+_messages_index_deinit()
+{
+	struct _threads_waiter *waiter;
+
+	_state = INDEX_EMPTY;
+	if (_messages) {
+		g_hash_table_destroy(_messages);
+		_messages = NULL;
+	}
+	if (_threads) {
+		g_hash_table_destroy(_threads);
+		_threads = NULL;
+	}
+	if (_waiters) {
+		while ((waiter = g_queue_pop_head(_waiters))) {
+			free(waiter);
+		}
+		g_queue_free(_waiters);
+		_waiters = NULL;
+	}
+	if (_changed) {
+		g_hash_table_destroy(_changed);
+		_changed = NULL;
+	}
+	/* phoneui_info_deinit dropped the subscription */
+	_changes_registered = FALSE;
+}
@@ -0,0 +1,35 @@
+/*
+ *  Copyright (C) 2026
+ *      Authors (alphabetical) :
+ *		agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ */
+
+
+#ifndef _MESSAGES_INDEX_H
+#define _MESSAGES_INDEX_H
+
+#include <glib.h>
+
+/* in-process index of the message threads by normalized peer number. It
+ * gets built on the first request and kept up to date from the message
+ * change signals. Requests made while building are answered once it is
+ * ready, later ones right away */
+int _messages_index_threads_get(void (*callback)(GError *, GHashTable **, int, gpointer),
+				gpointer data);
+void _messages_index_deinit();
+
+#endif
@@ -0,0 +1,386 @@
+/*
+ *  Copyright (C) 2026
+ *      Authors (alphabetical) :
+ *		agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include "outbox.h"
+
+/* rewrite the journal once it holds that many finished records */
+#define OUTBOX_COMPACT_THRESHOLD 64
+
+struct _outbox_entry {
+	int id;
+	char *number;
+	char *message;
+	char *pim_path;
+	int failures;
+	gboolean sending;	/* handed out, not journaled */
+};
+
+static char *journal_path = NULL;
+static FILE *journal = NULL;
+/* flock()ed by the one process that replays and compacts the journal */
+static int lock_fd = -1;
+/* id -> struct _outbox_entry, for all entries not done yet */
+static GHashTable *pending = NULL;
+static int last_id = 0;
+static int finished = 0;
+
+static void
+_entry_free(gpointer data)
+{
+	struct _outbox_entry *entry = data;
+
+	free(entry->number);
+	free(entry->message);
+	free(entry->pim_path);
+	free(entry);
+}
+
+static void
+_entry_write(FILE *f, struct _outbox_entry *entry)
+{
+	int i;
+	char *message = g_strescape(entry->message, NULL);
+
+	fprintf(f, "Q %d %s %s\n", entry->id, entry->number, message);
+	if (entry->pim_path) {
+		fprintf(f, "S %d %s\n", entry->id, entry->pim_path);
+	}
+	for (i = 0; i < entry->failures; i++) {
+		fprintf(f, "F %d\n", entry->id);
+	}
+	g_free(message);
+}
+
+static void
+_journal_append(const char *fmt, ...)
+{
+	va_list ap;
+
+	if (!journal)
+		return;
+	va_start(ap, fmt);
+	vfprintf(journal, fmt, ap);
+	va_end(ap);
+	/* hands the record to the kernel, so it survives us crashing while
+	 * talking to the modem - but not a power loss, there is no fsync */
+	fflush(journal);
+}
+
+static void
+_journal_line(char *line)
+{
+	char **fields;
+	int id;
+	struct _outbox_entry *entry;
+
+	fields = g_strsplit(g_strchomp(line), " ", 4);
+	if (!fields[0] || !fields[1]) {
+		g_strfreev(fields);
+		return;
+	}
+	id = atoi(fields[1]);
+	if (id > last_id) {
+		last_id = id;
+	}
+
+	if (!strcmp(fields[0], "Q") && fields[2] && fields[3]) {
+		entry = malloc(sizeof(*entry));
+		entry->id = id;
+		entry->number = strdup(fields[2]);
+		entry->message = g_strcompress(fields[3]);
+		entry->pim_path = NULL;
+		entry->failures = 0;
+		entry->sending = FALSE;
+		g_hash_table_replace(pending, GINT_TO_POINTER(id), entry);
+	}
+	else if (!strcmp(fields[0], "F")) {
+		entry = g_hash_table_lookup(pending, GINT_TO_POINTER(id));
+		if (entry) {
+			entry->failures++;
+		}
+	}
+	else if (!strcmp(fields[0], "S") && fields[2]) {
+		entry = g_hash_table_lookup(pending, GINT_TO_POINTER(id));
+		if (entry) {
+			free(entry->pim_path);
+			entry->pim_path = strdup(fields[2]);
+		}
+	}
+	else if (!strcmp(fields[0], "D") || !strcmp(fields[0], "X")) {
+		g_hash_table_remove(pending, GINT_TO_POINTER(id));
+	}
+	g_strfreev(fields);
+}
+
+static void
+_journal_compact()
+{
+	char *tmp_path;
+	FILE *f;
+	GHashTableIter iter;
+	gpointer entry;
+
+	tmp_path = g_strdup_printf("%s.new", journal_path);
+	f = fopen(tmp_path, "w");
+	if (!f) {
+		g_warning("Can't compact the SMS outbox %s: %s",
+			  tmp_path, strerror(errno));
+		g_free(tmp_path);
+		return;
+	}
+	g_hash_table_iter_init(&iter, pending);
+	while (g_hash_table_iter_next(&iter, NULL, &entry)) {
+		_entry_write(f, entry);
+	}
+	fflush(f);
+	fclose(f);
+
+	/* the old journal stays valid until the new one replaces it */
+	if (journal) {
+		fclose(journal);
+	}
+	if (g_rename(tmp_path, journal_path)) {
+		g_warning("Can't replace the SMS outbox %s: %s",
+			  journal_path, strerror(errno));
+	}
+	g_free(tmp_path);
+	journal = fopen(journal_path, "a");
+	finished = 0;
+	g_debug("Compacted the SMS outbox: %d entries pending",
+		g_hash_table_size(pending));
+}
+
+static gboolean
+_journal_lock()
+{
+	char *lock_path;
+
+	lock_path = g_strdup_printf("%s.lock", journal_path);
+	lock_fd = open(lock_path, O_RDWR | O_CREAT, 0600);
+	if (lock_fd < 0) {
+		g_warning("Can't open the SMS outbox lock %s: %s",
+			  lock_path, strerror(errno));
+		g_free(lock_path);
+		return FALSE;
+	}
+	g_free(lock_path);
+	if (flock(lock_fd, LOCK_EX | LOCK_NB)) {
+		close(lock_fd);
+		lock_fd = -1;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static void
+_journal_read()
+{
+	GIOChannel *channel;
+	GError *error = NULL;
+	char *line;
+
+	channel = g_io_channel_new_file(journal_path, "r", NULL);
+	if (!channel)
+		return;
+	/* the messages are escaped, no need to convert anything */
+	g_io_channel_set_encoding(channel, NULL, NULL);
+	while (g_io_channel_read_line(channel, &line, NULL, NULL, &error)
+			== G_IO_STATUS_NORMAL) {
+		_journal_line(line);
+		g_free(line);
+	}
+	if (error) {
+		g_warning("Can't read the SMS outbox %s: %s",
+			  journal_path, error->message);
+		g_error_free(error);
+	}
+	g_io_channel_unref(channel);
+}
+
+void
+_outbox_load_config(GKeyFile *keyfile)
+{
+	char *dir;
+
+	journal_path = g_key_file_get_string(keyfile, "sms", "outbox", NULL);
+	if (!journal_path) {
+		journal_path = g_build_filename(g_get_user_data_dir(),
+						"libphoneui", "outbox", NULL);
+	}
+	dir = g_path_get_dirname(journal_path);
+	g_mkdir_with_parents(dir, 0700);
+	g_free(dir);
+
+	pending = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+					NULL, _entry_free);
+	/* replaying and compacting from two processes would send the same
+	 * SMS twice and drop records, so only the first one gets an outbox */
+	if (!_journal_lock()) {
+		g_message("The SMS outbox %s is owned by another process, "
+			  "not using it", journal_path);
+		return;
+	}
+	_journal_read();
+	if (g_hash_table_size(pending)) {
+		g_message("%d SMS left in the outbox",
+			  g_hash_table_size(pending));
+	}
+
+	/* start every run with only the pending entries */
+	_journal_compact();
+	if (!journal) {
+		g_warning("Can't open the SMS outbox %s: %s",
+			  journal_path, strerror(errno));
+	}
+}
+
+int
+_outbox_queued(const char *number, const char *message)
+{
+	struct _outbox_entry *entry;
+
+	if (!journal)
+		return 0;
+
+	entry = malloc(sizeof(*entry));
+	entry->id = ++last_id;
+	entry->number = strdup(number);
+	entry->message = strdup(message);
+	entry->pim_path = NULL;
+	entry->failures = 0;
+	entry->sending = TRUE;
+	g_hash_table_insert(pending, GINT_TO_POINTER(entry->id), entry);
+
+	_entry_write(journal, entry);
+	fflush(journal);
+	return entry->id;
+}
+
+void
+_outbox_saved(int id, const char *pim_path)
+{
+	struct _outbox_entry *entry;
+
+	if (!journal || !id || !pim_path)
+		return;
+	entry = g_hash_table_lookup(pending, GINT_TO_POINTER(id));
+	if (!entry)
+		return;
+	free(entry->pim_path);
+	entry->pim_path = strdup(pim_path);
+	_journal_append("S %d %s\n", id, pim_path);
+}
+
+void
+_outbox_done(int id, gboolean sent)
+{
+	if (!journal || !id)
+		return;
+	g_hash_table_remove(pending, GINT_TO_POINTER(id));
+	_journal_append("%s %d\n", (sent) ? "D" : "X", id);
+	if (++finished >= OUTBOX_COMPACT_THRESHOLD) {
+		_journal_compact();
+	}
+}
+
+int
+_outbox_failed(int id)
+{
+	struct _outbox_entry *entry;
+
+	if (!journal || !id)
+		return 0;
+	entry = g_hash_table_lookup(pending, GINT_TO_POINTER(id));
+	if (!entry)
+		return 0;
+	entry->failures++;
+	entry->sending = FALSE;
+	_journal_append("F %d\n", id);
+	return entry->failures;
+}
+
+guint
+_outbox_pending_count()
+{
+	guint count = 0;
+	GHashTableIter iter;
+	gpointer entry;
+
+	if (!pending)
+		return 0;
+	g_hash_table_iter_init(&iter, pending);
+	while (g_hash_table_iter_next(&iter, NULL, &entry)) {
+		if (!((struct _outbox_entry *) entry)->sending)
+			count++;
+	}
+	return count;
+}
+
+void
+_outbox_pending_foreach(void (*func)(int id, const char *number,
+				     const char *message,
+				     const char *pim_path, gpointer),
+			gpointer data)
+{
+	GHashTableIter iter;
+	gpointer _entry;
+	struct _outbox_entry *entry;
+
+	if (!pending)
+		return;
+	g_hash_table_iter_init(&iter, pending);
+	while (g_hash_table_iter_next(&iter, NULL, &_entry)) {
+		entry = _entry;
+		if (entry->sending)
+			continue;
+		entry->sending = TRUE;
+		func(entry->id, entry->number, entry->message,
+		     entry->pim_path, data);
+	}
+}
+
+void
+_outbox_deinit()
+{
+	if (journal) {
+		fclose(journal);
+		journal = NULL;
+	}
+	if (lock_fd >= 0) {
+		close(lock_fd);
+		lock_fd = -1;
+	}
+	if (pending) {
+		g_hash_table_destroy(pending);
+		pending = NULL;
+	}
+	g_free(journal_path);
+	journal_path = NULL;
+}
@@ -0,0 +1,48 @@
+/*
+ *  Copyright (C) 2026
+ *      Authors (alphabetical) :
+ *		agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ */
+#ifndef _OUTBOX_H
+#define _OUTBOX_H
+
+#include <glib.h>
+
+/* append-only journal of the SMS being sent, one entry per recipient.
+ * Entries are queued, optionally marked as saved in opimd, marked as
+ * failed any number of times and finally marked as done; whatever is
+ * not done survives a restart. Disabled
+ * (all ids 0) when the journal can't be opened or another process
+ * holds its lock */
+void _outbox_load_config(GKeyFile *keyfile);
+int _outbox_queued(const char *number, const char *message);
+void _outbox_saved(int id, const char *pim_path);
+void _outbox_done(int id, gboolean sent);
+/* keeps the entry for another attempt, returns how often it failed so
+ * far - 0 if it isn't journaled */
+int _outbox_failed(int id);
+/* the entries waiting to be sent again: left over from the last run or
+ * failed. foreach hands them out, they don't come up again unless they
+ * fail once more */
+guint _outbox_pending_count();
+void _outbox_pending_foreach(void (*func)(int id, const char *number,
+					  const char *message,
+					  const char *pim_path, gpointer),
+			     gpointer data);
+void _outbox_deinit();
+
+#endif
@@ -23,6 +23,7 @@
 
 
 #include <stdlib.h>
+#include <string.h>
 #include <dbus/dbus-glib.h>
 #include <dbus/dbus.h>
 
@@ -32,46 +33,148 @@
 #include "phoneui-info.h"
 #include "phoneui-utils-contacts.h"
 #include "dbus.h"
+#include "helpers.h"
+#include "latency.h"
+
+/* the services the info functions talk to - their proxies come from the
+ * shared cache in dbus.c, so the utils functions use the same ones and
+ * a restarted service gets fresh ones */
+struct _fso_service {
+	void *(*get)(DBusGConnection *, const char *, const char *);
+	const char *iface;
+	const char *busname;
+	const char *path;
+};
+
+/* same interface key as _DBUS_PROXY */
+#define FSO_SERVICE(func, busname, path) \
+	{ (void *(*)(DBusGConnection *, const char *, const char *)) func, \
+	  #func, busname, path }
 
 struct _fso {
-	FreeSmartphoneUsage *usage;
-	FreeSmartphoneGSMCall *gsm_call;
-	FreeSmartphoneGSMNetwork *gsm_network;
-	FreeSmartphoneGSMPDP *gsm_pdp;
-	FreeSmartphoneDeviceIdleNotifier *idle_notifier;
-	FreeSmartphoneDeviceInput *input;
-	FreeSmartphoneDevicePowerSupply *power_supply;
-	FreeSmartphonePreferences *preferences;
-	FreeSmartphonePIMMessages *pim_messages;
-	FreeSmartphonePIMContacts *pim_contacts;
-	FreeSmartphonePIMCalls *pim_calls;
-	FreeSmartphonePIMTasks *pim_tasks;
+	struct _fso_service usage;
+	struct _fso_service gsm_call;
+	struct _fso_service gsm_network;
+	struct _fso_service gsm_pdp;
+	struct _fso_service input;
+	struct _fso_service power_supply;
+	struct _fso_service preferences;
+	struct _fso_service pim_messages;
+	struct _fso_service pim_contacts;
+	struct _fso_service pim_calls;
+	struct _fso_service pim_tasks;
+};
+static struct _fso fso = {
+	FSO_SERVICE(free_smartphone_get_usage_proxy,
+		  FSO_FRAMEWORK_USAGE_ServiceDBusName,
+		  FSO_FRAMEWORK_USAGE_ServicePathPrefix),
+	FSO_SERVICE(free_smartphone_gsm_get_call_proxy,
+		  FSO_FRAMEWORK_GSM_ServiceDBusName,
+		  FSO_FRAMEWORK_GSM_DeviceServicePath),
+	FSO_SERVICE(free_smartphone_gsm_get_network_proxy,
+		  FSO_FRAMEWORK_GSM_ServiceDBusName,
+		  FSO_FRAMEWORK_GSM_DeviceServicePath),
+	FSO_SERVICE(free_smartphone_gsm_get_p_d_p_proxy,
+		  FSO_FRAMEWORK_GSM_ServiceDBusName,
+		  FSO_FRAMEWORK_GSM_DeviceServicePath),
+	FSO_SERVICE(free_smartphone_device_get_input_proxy,
+		  FSO_FRAMEWORK_DEVICE_ServiceDBusName,
+		  FSO_FRAMEWORK_DEVICE_InputServicePath),
+	FSO_SERVICE(free_smartphone_device_get_power_supply_proxy,
+		  FSO_FRAMEWORK_DEVICE_ServiceDBusName,
+		  FSO_FRAMEWORK_DEVICE_PowerSupplyServicePath),
+	FSO_SERVICE(free_smartphone_get_preferences_proxy,
+		  FSO_FRAMEWORK_PREFERENCES_ServiceDBusName,
+		  FSO_FRAMEWORK_PREFERENCES_ServicePathPrefix),
+	FSO_SERVICE(free_smartphone_pim_get_messages_proxy,
+		  FSO_FRAMEWORK_PIM_ServiceDBusName,
+		  FSO_FRAMEWORK_PIM_MessagesServicePath),
+	FSO_SERVICE(free_smartphone_pim_get_contacts_proxy,
+		  FSO_FRAMEWORK_PIM_ServiceDBusName,
+		  FSO_FRAMEWORK_PIM_ContactsServicePath),
+	FSO_SERVICE(free_smartphone_pim_get_calls_proxy,
+		  FSO_FRAMEWORK_PIM_ServiceDBusName,
+		  FSO_FRAMEWORK_PIM_CallsServicePath),
+	FSO_SERVICE(free_smartphone_pim_get_tasks_proxy,
+		  FSO_FRAMEWORK_PIM_ServiceDBusName,
+		  FSO_FRAMEWORK_PIM_TasksServicePath),
+};
+
+/* last known values as delivered by the signals or requests - the
+ * request functions answer from here instead of asking the service */
+struct _cache {
+	gboolean signal_strength_valid;
+	int signal_strength;
+	gboolean capacity_valid;
+	int capacity;
+	gboolean missed_calls_valid;
+	int missed_calls;
+	gboolean unread_messages_valid;
+	int unread_messages;
+	char *profile;
+	GHashTable *network_status;
 };
-static struct _fso fso;
-
-
-static GList *callbacks_contact_changes = NULL;
-static GList *callbacks_message_changes = NULL;
-static GList *callbacks_call_changes = NULL;
-static GList *callbacks_profile_changes = NULL;
-static GList *callbacks_capacity_changes = NULL;
-static GList *callbacks_missed_calls = NULL;
-static GList *callbacks_unread_messages = NULL;
-static GList *callbacks_unfinished_tasks = NULL;
-static GList *callbacks_resource_changes = NULL;
-static GList *callbacks_network_status = NULL;
-static GList *callbacks_pdp_context_status = NULL;
-static GList *callbacks_signal_strength = NULL;
-static GList *callbacks_input_events = NULL;
-static GList *callbacks_call_status = NULL;
+static struct _cache cache;
+
+/* high-frequency signals are delivered to the subscribers at most once
+ * per interval - changes within the window only keep the latest value */
+struct _coalesce {
+	const char *name;
+	guint interval;
+	gdouble last;
+	guint timeout;
+	int value;
+	GHashTable *properties;
+	void (*deliver)(struct _coalesce *);
+};
+static void _deliver_signal_strength(struct _coalesce *c);
+static void _deliver_capacity(struct _coalesce *c);
+static void _deliver_network_status(struct _coalesce *c);
+static struct _coalesce coalesce_signal_strength =
+	{ "signal_strength", 0, 0.0, 0, 0, NULL, _deliver_signal_strength };
+static struct _coalesce coalesce_capacity =
+	{ "capacity", 0, 0.0, 0, 0, NULL, _deliver_capacity };
+static struct _coalesce coalesce_network_status =
+	{ "network_status", 0, 0.0, 0, 0, NULL, _deliver_network_status };
+static GTimer *coalesce_timer = NULL;
+static void _coalesce_reset(struct _coalesce *c);
+
+
+/* subscriptions of one event type: a contiguous array of callback packs
+ * of the type matching the event, each starting with its handle - a
+ * handle of 0 marks an entry unregistered while the array was dispatched.
+ * The signals feeding the event are only connected while there are
+ * subscribers, forget drops cached values that can't be kept current
+ * without them */
+#define SUBSCRIPTION_SIGNALS 3
+struct _subscriptions {
+	GArray *packs;
+	guint size;
+	guint dispatching;
+	gboolean removed;
+	gdouble dispatch_start;
+	struct _fso_service *service;
+	gpointer proxy;		/* held while connected */
+	const char *signals[SUBSCRIPTION_SIGNALS];
+	GCallback handlers[SUBSCRIPTION_SIGNALS];
+	gulong handler_ids[SUBSCRIPTION_SIGNALS];
+	void (*forget)();
+};
+
+#define SUBSCRIPTIONS(pack_type, svc, forget_func) \
+	.packs = NULL, .size = sizeof(struct pack_type), .dispatching = 0, \
+	.removed = FALSE, .service = svc, .proxy = NULL, .forget = forget_func
+
 static GHashTable *single_contact_changes = NULL;
 
 struct _cb_pim_changes_pack {
+	int handle;
 	void (*callback)(void *, const char *, enum PhoneuiInfoChangeType);
 	void *data;
 };
 
 struct _cb_pim_single_changes_pack {
+	int handle;
 	void (*callback)(void *, int, enum PhoneuiInfoChangeType);
 	void *data;
 };
@@ -79,41 +182,65 @@ struct _cb_pim_single_changes_pack {
 struct _single_pim_changes_pack {
 	int entryid;
 	GObject *proxy;
-	GList *callbacks;
+	struct _subscriptions callbacks;
 };
 
 struct _cb_hashtable_pack {
+	int handle;
 	void (*callback)(void *, GHashTable *);
 	void *data;
 };
 struct _cb_int_pack {
+	int handle;
 	void (*callback)(void *, int);
 	void *data;
 };
 struct _cb_charp_pack {
+	int handle;
 	void (*callback)(void *, const char *);
 	void *data;
 };
 struct _cb_input_event_pack {
+	int handle;
 	void (*callback)(void *, const char *, FreeSmartphoneDeviceInputState, int);
 	void *data;
 };
 struct _cb_resource_changes_pack {
+	int handle;
 	void (*callback)(void *, const char*, gboolean, GHashTable *);
 	void *data;
 };
 struct _cb_3int_pack {
+	int handle;
 	void (*callback)(void *, int, int, int);
 	void *data;
 };
 struct _cb_int_hashtable_pack {
+	int handle;
 	void (*callback)(void *, int, GHashTable *);
 	void *data;
 };
 struct _cb_gsm_context_status_pack {
+	int handle;
 	void (*callback)(void *, FreeSmartphoneGSMContextStatus, GHashTable *);
 	void *data;
 };
+struct _cb_cached_int_pack {
+	void (*callback)(void *, int);
+	void *data;
+	int value;
+};
+struct _cb_cached_charp_pack {
+	void (*callback)(void *, const char *);
+	void *data;
+	char *value;
+};
+struct _cb_cached_hashtable_pack {
+	void (*callback)(void *, GHashTable *);
+	void *data;
+	GHashTable *value;
+};
+
 
 
 static void _pim_missed_calls_handler(GObject *source, int amount, gpointer data);
@@ -128,7 +255,6 @@ static void _capacity_changed_handler(GObject *source, int energy, gpointer data
 static void _network_status_handler(GObject *source, GHashTable *properties, gpointer data);
 static void _pdp_context_status_handler(GObject *source, FreeSmartphoneGSMContextStatus status, GHashTable *properties, gpointer data);
 static void _signal_strength_handler(GObject *source, int signal, gpointer data);
-static void _idle_notifier_handler(GObject *source, int state, gpointer data);
 static void _pim_contact_new_handler(GObject *source, const char *path, gpointer data);
 static void _pim_contact_updated_handler(GObject *source, const char *path, GHashTable *content, gpointer data);
 static void _pim_contact_deleted_handler(GObject *source, const char *path, gpointer data);
@@ -144,6 +270,8 @@ static void _pim_unread_messages_callback( GObject* source, GAsyncResult* res, g
 // static void _pim_unfinished_tasks_callback(GError *error, int amount, gpointer userdata);
 static void _list_resources_callback(GObject *source, GAsyncResult *res, gpointer data);
 static void _resource_state_callback(GObject *source, GAsyncResult *res, gpointer data);
+static void _list_resources_snapshot_callback(GObject *source, GAsyncResult *res, gpointer data);
+static void _resource_snapshot_state_callback(GObject *source, GAsyncResult *res, gpointer data);
 static void _get_profile_callback(GObject *source, GAsyncResult *res, gpointer data);
 static void _get_capacity_callback(GObject *source, GAsyncResult *res, gpointer data);
 static void _get_network_status_callback(GObject *source, GAsyncResult *res, gpointer data);
@@ -153,34 +281,562 @@ static void _get_signal_strength_callback(GObject *source, GAsyncResult *res, gp
 
 static void _name_owner_changed(DBusGProxy *proxy, const char *name, const char *prev, const char *new, gpointer data);
 
-static void _execute_pim_changed_callbacks(GList *cbs, const char *path, enum PhoneuiInfoChangeType type);
-static void _execute_pim_single_changed_callbacks(GList* cbs, int entryid, enum PhoneuiInfoChangeType type);
-static void _execute_int_callbacks(GList *cbs, int value);
-static void _execute_charp_callbacks(GList *cbs, const char *value);
-static void _execute_input_event_callbacks(GList *cbs, const char *value1, FreeSmartphoneDeviceInputState value2, int value3);
-static void _execute_hashtable_callbacks(GList *cbs, GHashTable *properties);
-static void _execute_resource_callbacks(GList *cbs, const char *resource, gboolean state, GHashTable *properties);
-static void _execute_int_hashtable_callbacks(GList *cbs, int val1, GHashTable *val2);
-static void _execute_gsm_context_status_callbacks(GList *cbs, FreeSmartphoneGSMContextStatus val1, GHashTable *val2);
+static void _forget_profile();
+static void _forget_capacity();
+static void _forget_missed_calls();
+static void _forget_unread_messages();
+static void _forget_network_status();
+static void _forget_signal_strength();
+
+static struct _subscriptions callbacks_contact_changes = {
+	SUBSCRIPTIONS(_cb_pim_changes_pack, &fso.pim_contacts, NULL),
+	.signals = { "new-contact", "updated-contact", "deleted-contact" },
+	.handlers = { G_CALLBACK(_pim_contact_new_handler),
+		      G_CALLBACK(_pim_contact_updated_handler),
+		      G_CALLBACK(_pim_contact_deleted_handler) }
+};
+static struct _subscriptions callbacks_message_changes = {
+	SUBSCRIPTIONS(_cb_pim_changes_pack, &fso.pim_messages, NULL),
+	.signals = { "new-message", "updated-message", "deleted-message" },
+	.handlers = { G_CALLBACK(_pim_message_new_handler),
+		      G_CALLBACK(_pim_message_updated_handler),
+		      G_CALLBACK(_pim_message_deleted_handler) }
+};
+static struct _subscriptions callbacks_call_changes = {
+	SUBSCRIPTIONS(_cb_pim_changes_pack, &fso.pim_calls, NULL),
+	.signals = { "new-call" },
+	.handlers = { G_CALLBACK(_pim_new_call_handler) }
+};
+static struct _subscriptions callbacks_profile_changes = {
+	SUBSCRIPTIONS(_cb_charp_pack, &fso.preferences, _forget_profile),
+	.signals = { "changed" },
+	.handlers = { G_CALLBACK(_profile_changed_handler) }
+};
+static struct _subscriptions callbacks_capacity_changes = {
+	SUBSCRIPTIONS(_cb_int_pack, &fso.power_supply, _forget_capacity),
+	.signals = { "capacity" },
+	.handlers = { G_CALLBACK(_capacity_changed_handler) }
+};
+static struct _subscriptions callbacks_missed_calls = {
+	SUBSCRIPTIONS(_cb_int_pack, &fso.pim_calls, _forget_missed_calls),
+	.signals = { "new-missed-calls" },
+	.handlers = { G_CALLBACK(_pim_missed_calls_handler) }
+};
+static struct _subscriptions callbacks_unread_messages = {
+	SUBSCRIPTIONS(_cb_int_pack, &fso.pim_messages, _forget_unread_messages),
+	.signals = { "unread-messages" },
+	.handlers = { G_CALLBACK(_pim_unread_messages_handler) }
+};
+static struct _subscriptions callbacks_unfinished_tasks = {
+	SUBSCRIPTIONS(_cb_int_pack, &fso.pim_tasks, NULL),
+	.signals = { "unfinished-tasks" },
+	.handlers = { G_CALLBACK(_pim_unfinished_tasks_handler) }
+};
+static struct _subscriptions callbacks_resource_changes = {
+	SUBSCRIPTIONS(_cb_resource_changes_pack, &fso.usage, NULL),
+	.signals = { "resource-changed" },
+	.handlers = { G_CALLBACK(_resource_changed_handler) }
+};
+static struct _subscriptions callbacks_network_status = {
+	SUBSCRIPTIONS(_cb_hashtable_pack, &fso.gsm_network, _forget_network_status),
+	.signals = { "status" },
+	.handlers = { G_CALLBACK(_network_status_handler) }
+};
+static struct _subscriptions callbacks_pdp_context_status = {
+	SUBSCRIPTIONS(_cb_gsm_context_status_pack, &fso.gsm_pdp, NULL),
+	.signals = { "context-status" },
+	.handlers = { G_CALLBACK(_pdp_context_status_handler) }
+};
+static struct _subscriptions callbacks_signal_strength = {
+	SUBSCRIPTIONS(_cb_int_pack, &fso.gsm_network, _forget_signal_strength),
+	.signals = { "signal-strength" },
+	.handlers = { G_CALLBACK(_signal_strength_handler) }
+};
+static struct _subscriptions callbacks_input_events = {
+	SUBSCRIPTIONS(_cb_input_event_pack, &fso.input, NULL),
+	.signals = { "event" },
+	.handlers = { G_CALLBACK(_device_input_event_handler) }
+};
+static struct _subscriptions callbacks_call_status = {
+	SUBSCRIPTIONS(_cb_int_hashtable_pack, &fso.gsm_call, NULL),
+	.signals = { "call-status" },
+	.handlers = { G_CALLBACK(_call_status_handler) }
+};
+static struct _subscriptions *all_subscriptions[] = {
+	&callbacks_contact_changes, &callbacks_message_changes,
+	&callbacks_call_changes, &callbacks_profile_changes,
+	&callbacks_capacity_changes, &callbacks_missed_calls,
+	&callbacks_unread_messages, &callbacks_unfinished_tasks,
+	&callbacks_resource_changes, &callbacks_network_status,
+	&callbacks_pdp_context_status, &callbacks_signal_strength,
+	&callbacks_input_events, &callbacks_call_status,
+	NULL
+};
+static int last_handle = 0;
+
+static void _execute_pim_changed_callbacks(struct _subscriptions *cbs, const char *path, enum PhoneuiInfoChangeType type);
+static void _execute_pim_single_changed_callbacks(struct _subscriptions *cbs, int entryid, enum PhoneuiInfoChangeType type);
+static void _execute_int_callbacks(struct _subscriptions *cbs, int value);
+static void _execute_charp_callbacks(struct _subscriptions *cbs, const char *value);
+static void _execute_input_event_callbacks(struct _subscriptions *cbs, const char *value1, FreeSmartphoneDeviceInputState value2, int value3);
+static void _execute_hashtable_callbacks(struct _subscriptions *cbs, GHashTable *properties);
+static void _execute_resource_callbacks(struct _subscriptions *cbs, const char *resource, gboolean state, GHashTable *properties);
+static void _execute_int_hashtable_callbacks(struct _subscriptions *cbs, int val1, GHashTable *val2);
+static void _execute_gsm_context_status_callbacks(struct _subscriptions *cbs, FreeSmartphoneGSMContextStatus val1, GHashTable *val2);
+
+/* a new reference, requests drop it in their callback */
+static gpointer
+_fso_proxy(struct _fso_service *service)
+{
+	return _dbus_proxy(service->get, service->iface, service->busname,
+			   service->path);
+}
+
+static gboolean
+_subscriptions_connected(struct _subscriptions *subs)
+{
+	return subs->handler_ids[0] != 0;
+}
+
+static void
+_subscriptions_connect(struct _subscriptions *subs)
+{
+	int i;
+	gpointer proxy;
+
+	if (!subs->service || _subscriptions_connected(subs))
+		return;
+
+	proxy = _fso_proxy(subs->service);
+	if (!proxy)
+		return;
+	subs->proxy = proxy;
+	for (i = 0; i < SUBSCRIPTION_SIGNALS && subs->signals[i]; i++) {
+		subs->handler_ids[i] = g_signal_connect(G_OBJECT(proxy),
+				subs->signals[i], subs->handlers[i], NULL);
+	}
+}
 
 static void
-_callbacks_list_free_foreach(gpointer _data, gpointer userdata)
+_subscriptions_unbind(struct _subscriptions *subs)
 {
-	struct _cb_hashtable_pack *data = (struct _cb_hashtable_pack *) _data;
-	(void) userdata;
-	if (data->data)
-		free(data->data);
-	free(data);
+	int i;
+
+	for (i = 0; i < SUBSCRIPTION_SIGNALS && subs->signals[i]; i++) {
+		g_signal_handler_disconnect(subs->proxy, subs->handler_ids[i]);
+		subs->handler_ids[i] = 0;
+	}
+	g_object_unref(subs->proxy);
+	subs->proxy = NULL;
 }
 
 static void
-callbacks_list_free(GList *list)
+_subscriptions_disconnect(struct _subscriptions *subs)
 {
-	if (!list)
+	if (!_subscriptions_connected(subs))
 		return;
 
-	g_list_foreach(list, _callbacks_list_free_foreach, NULL);
-	g_list_free(list);
+	_subscriptions_unbind(subs);
+	if (subs->forget) {
+		subs->forget();
+	}
+}
+
+/* the service got restarted - move the connected subscriptions over to
+ * the proxy dbus.c creates for the new one */
+static void
+_subscriptions_rebind(const char *busname)
+{
+	int i;
+	struct _subscriptions *subs;
+
+	for (i = 0; all_subscriptions[i]; i++) {
+		subs = all_subscriptions[i];
+		if (!_subscriptions_connected(subs) ||
+		    strcmp(subs->service->busname, busname))
+			continue;
+		_subscriptions_unbind(subs);
+		_subscriptions_connect(subs);
+	}
+}
+
+static int
+_subscriptions_add(struct _subscriptions *subs, gpointer pack, const char *name)
+{
+	if (!subs->packs) {
+		subs->packs = g_array_new(FALSE, FALSE, subs->size);
+	}
+	_subscriptions_connect(subs);
+	*(int *)pack = ++last_handle;
+	g_array_append_vals(subs->packs, pack, 1);
+	g_debug("Registered callback %d for %s", last_handle, name);
+
+	return last_handle;
+}
+
+#define SUBSCRIPTION_HANDLE(subs, i) \
+	(*(int *)((subs)->packs->data + (i) * (subs)->size))
+
+static gboolean
+_subscriptions_empty(struct _subscriptions *subs)
+{
+	guint i;
+
+	if (!subs->packs)
+		return TRUE;
+	for (i = 0; i < subs->packs->len; i++) {
+		if (SUBSCRIPTION_HANDLE(subs, i))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+
+static gboolean
+_subscriptions_remove(struct _subscriptions *subs, int handle)
+{
+	guint i;
+
+	if (!subs->packs)
+		return FALSE;
+
+	for (i = 0; i < subs->packs->len; i++) {
+		if (SUBSCRIPTION_HANDLE(subs, i) != handle)
+			continue;
+		if (subs->dispatching) {
+			/* don't move entries under the running dispatch */
+			SUBSCRIPTION_HANDLE(subs, i) = 0;
+			subs->removed = TRUE;
+		}
+		else {
+			g_array_remove_index(subs->packs, i);
+		}
+		if (_subscriptions_empty(subs)) {
+			_subscriptions_disconnect(subs);
+		}
+		return TRUE;
+	}
+	return FALSE;
+}
+
+static void
+_subscriptions_dispatch_begin(struct _subscriptions *subs)
+{
+	if (!subs->dispatching++)
+		subs->dispatch_start = _latency_begin();
+}
+
+static void
+_subscriptions_dispatch_end(struct _subscriptions *subs)
+{
+	guint i;
+
+	if (--subs->dispatching)
+		return;
+	if (!subs->packs) {
+		subs->removed = FALSE;
+		return;
+	}
+	/* cost per subscriber */
+	_latency_end(subs->dispatch_start, "info dispatch", subs->packs->len);
+	if (!subs->removed)
+		return;
+
+	subs->removed = FALSE;
+	for (i = subs->packs->len; i > 0; i--) {
+		if (!SUBSCRIPTION_HANDLE(subs, i - 1)) {
+			g_array_remove_index(subs->packs, i - 1);
+		}
+	}
+}
+
+static void
+_subscriptions_clear(struct _subscriptions *subs)
+{
+	guint i;
+
+	_subscriptions_disconnect(subs);
+	if (subs->dispatching && subs->packs) {
+		/* a subscriber cleared it - the running dispatch still walks
+		 * the array, so only mark the entries for its end */
+		for (i = 0; i < subs->packs->len; i++) {
+			SUBSCRIPTION_HANDLE(subs, i) = 0;
+		}
+		subs->removed = TRUE;
+		return;
+	}
+	/* the user data belongs to the subscriber - only drop the packs */
+	if (subs->packs) {
+		g_array_free(subs->packs, TRUE);
+		subs->packs = NULL;
+	}
+	subs->removed = FALSE;
+}
+
+static void
+_single_pim_changes_free(struct _single_pim_changes_pack *pack)
+{
+	g_debug("Releasing the Contact proxy for %d", pack->entryid);
+	g_object_unref(pack->proxy);
+	_subscriptions_clear(&pack->callbacks);
+	free(pack);
+}
+
+static void
+_single_pim_changes_release_unused(struct _single_pim_changes_pack *pack)
+{
+	if (pack->callbacks.dispatching || !_subscriptions_empty(&pack->callbacks))
+		return;
+	g_hash_table_remove(single_contact_changes, &pack->entryid);
+	_single_pim_changes_free(pack);
+}
+
+void
+phoneui_info_unregister(int handle)
+{
+	int i;
+	GHashTableIter iter;
+	gpointer _pack;
+	struct _single_pim_changes_pack *pack;
+
+	if (handle <= 0)
+		return;
+
+	for (i = 0; all_subscriptions[i]; i++) {
+		if (_subscriptions_remove(all_subscriptions[i], handle)) {
+			g_debug("Unregistered callback %d", handle);
+			return;
+		}
+	}
+
+	if (!single_contact_changes)
+		return;
+
+	g_hash_table_iter_init(&iter, single_contact_changes);
+	while (g_hash_table_iter_next(&iter, NULL, &_pack)) {
+		pack = _pack;
+		if (!_subscriptions_remove(&pack->callbacks, handle))
+			continue;
+		g_debug("Unregistered callback %d for contact %d",
+			handle, pack->entryid);
+		_single_pim_changes_release_unused(pack);
+		return;
+	}
+	g_debug("Callback %d not found - nothing to unregister", handle);
+}
+
+static gboolean
+_cached_int_idle(gpointer data)
+{
+	struct _cb_cached_int_pack *pack = data;
+	pack->callback(pack->data, pack->value);
+	free(pack);
+	return FALSE;
+}
+
+static gboolean
+_cached_charp_idle(gpointer data)
+{
+	struct _cb_cached_charp_pack *pack = data;
+	pack->callback(pack->data, pack->value);
+	free(pack->value);
+	free(pack);
+	return FALSE;
+}
+
+static gboolean
+_cached_hashtable_idle(gpointer data)
+{
+	struct _cb_cached_hashtable_pack *pack = data;
+	pack->callback(pack->data, pack->value);
+	g_hash_table_unref(pack->value);
+	free(pack);
+	return FALSE;
+}
+
+static void
+_cached_int_deliver(void (*callback)(void *, int), void *data, int value)
+{
+	struct _cb_cached_int_pack *pack = malloc(sizeof(*pack));
+	pack->callback = callback;
+	pack->data = data;
+	pack->value = value;
+	g_idle_add(_cached_int_idle, pack);
+}
+
+static void
+_cache_set_profile(const char *profile)
+{
+	free(cache.profile);
+	cache.profile = (profile) ? strdup(profile) : NULL;
+}
+
+static void
+_cache_set_network_status(GHashTable *properties)
+{
+	if (cache.network_status) {
+		g_hash_table_unref(cache.network_status);
+	}
+	cache.network_status = (properties) ? g_hash_table_ref(properties) : NULL;
+}
+
+static void
+_forget_profile()
+{
+	_cache_set_profile(NULL);
+}
+
+static void
+_forget_capacity()
+{
+	cache.capacity_valid = FALSE;
+	_coalesce_reset(&coalesce_capacity);
+}
+
+static void
+_forget_missed_calls()
+{
+	cache.missed_calls_valid = FALSE;
+}
+
+static void
+_forget_unread_messages()
+{
+	cache.unread_messages_valid = FALSE;
+}
+
+static void
+_forget_network_status()
+{
+	_cache_set_network_status(NULL);
+	_coalesce_reset(&coalesce_network_status);
+}
+
+static void
+_forget_signal_strength()
+{
+	cache.signal_strength_valid = FALSE;
+	_coalesce_reset(&coalesce_signal_strength);
+}
+
+static void
+_cache_invalidate(const char *name)
+{
+	if (!name || !strcmp(name, FSO_FRAMEWORK_GSM_ServiceDBusName)) {
+		cache.signal_strength_valid = FALSE;
+		_cache_set_network_status(NULL);
+	}
+	if (!name || !strcmp(name, FSO_FRAMEWORK_DEVICE_ServiceDBusName)) {
+		cache.capacity_valid = FALSE;
+	}
+	if (!name || !strcmp(name, FSO_FRAMEWORK_PIM_ServiceDBusName)) {
+		cache.missed_calls_valid = FALSE;
+		cache.unread_messages_valid = FALSE;
+	}
+	if (!name || !strcmp(name, FSO_FRAMEWORK_PREFERENCES_ServiceDBusName)) {
+		_cache_set_profile(NULL);
+	}
+}
+
+static void
+_coalesce_config(GKeyFile *keyfile, struct _coalesce *c)
+{
+	char *key;
+
+	key = g_strdup_printf("%s_interval", c->name);
+	if (g_key_file_has_key(keyfile, "info", key, NULL)) {
+		int interval = g_key_file_get_integer(keyfile, "info", key, NULL);
+		c->interval = (interval > 0) ? interval : 0;
+		g_debug("Delivering %s at most every %d ms", c->name, c->interval);
+	}
+	g_free(key);
+}
+
+void
+phoneui_info_load_config(GKeyFile *keyfile)
+{
+	_coalesce_config(keyfile, &coalesce_signal_strength);
+	_coalesce_config(keyfile, &coalesce_capacity);
+	_coalesce_config(keyfile, &coalesce_network_status);
+}
+
+static void
+_deliver_signal_strength(struct _coalesce *c)
+{
+	_execute_int_callbacks(&callbacks_signal_strength, c->value);
+}
+
+static void
+_deliver_capacity(struct _coalesce *c)
+{
+	_execute_int_callbacks(&callbacks_capacity_changes, c->value);
+}
+
+static void
+_deliver_network_status(struct _coalesce *c)
+{
+	GHashTable *properties = c->properties;
+
+	c->properties = NULL;
+	_execute_hashtable_callbacks(&callbacks_network_status, properties);
+	if (properties) {
+		g_hash_table_unref(properties);
+	}
+}
+
+static gboolean
+_coalesce_timeout(gpointer data)
+{
+	struct _coalesce *c = data;
+
+	c->timeout = 0;
+	c->last = g_timer_elapsed(coalesce_timer, NULL);
+	c->deliver(c);
+
+	return FALSE;
+}
+
+/* value and properties have to be set in c before */
+static void
+_coalesce_push(struct _coalesce *c)
+{
+	gdouble now, wait;
+
+	if (!c->interval) {
+		c->deliver(c);
+		return;
+	}
+	if (c->timeout) {
+		/* a delivery is already scheduled and will pick up the new value */
+		return;
+	}
+	if (!coalesce_timer) {
+		coalesce_timer = g_timer_new();
+	}
+
+	now = g_timer_elapsed(coalesce_timer, NULL);
+	wait = c->last + c->interval / 1000.0 - now;
+	if (c->last == 0.0 || wait <= 0.0) {
+		c->last = now;
+		c->deliver(c);
+		return;
+	}
+	c->timeout = g_timeout_add((guint)(wait * 1000) + 1,
+				   _coalesce_timeout, c);
+}
+
+static void
+_coalesce_reset(struct _coalesce *c)
+{
+	if (c->timeout) {
+		g_source_remove(c->timeout);
+		c->timeout = 0;
+	}
+	if (c->properties) {
+		g_hash_table_unref(c->properties);
+		c->properties = NULL;
+	}
+	c->last = 0.0;
 }
 
 int
@@ -198,86 +854,8 @@ phoneui_info_init()
 	dbus_g_proxy_connect_signal(dbus_proxy, "NameOwnerChanged",
 				    G_CALLBACK(_name_owner_changed), NULL, NULL);
 
-
-
-	fso.usage = free_smartphone_get_usage_proxy(_dbus(),
-				FSO_FRAMEWORK_USAGE_ServiceDBusName,
-				FSO_FRAMEWORK_USAGE_ServicePathPrefix);
-	g_signal_connect(G_OBJECT(fso.usage), "resource-changed",
-			 G_CALLBACK(_resource_changed_handler), NULL);
-
-	fso.gsm_call = free_smartphone_gsm_get_call_proxy(_dbus(),
-				FSO_FRAMEWORK_GSM_ServiceDBusName,
-				FSO_FRAMEWORK_GSM_DeviceServicePath);
-	g_signal_connect(G_OBJECT(fso.gsm_call), "call-status",
-			 G_CALLBACK(_call_status_handler), NULL);
-
-	fso.gsm_network = free_smartphone_gsm_get_network_proxy(_dbus(),
-				FSO_FRAMEWORK_GSM_ServiceDBusName,
-				FSO_FRAMEWORK_GSM_DeviceServicePath);
-	g_signal_connect(G_OBJECT(fso.gsm_network), "status",
-			 G_CALLBACK(_network_status_handler), NULL);
-	g_signal_connect(G_OBJECT(fso.gsm_network), "signal-strength",
-			 G_CALLBACK(_signal_strength_handler), NULL);
-
-	fso.gsm_pdp = free_smartphone_gsm_get_p_d_p_proxy(_dbus(),
-				FSO_FRAMEWORK_GSM_ServiceDBusName,
-				FSO_FRAMEWORK_GSM_DeviceServicePath);
-	g_signal_connect(G_OBJECT(fso.gsm_pdp), "context-status",
-			 G_CALLBACK(_pdp_context_status_handler), NULL);
-
-	fso.power_supply = free_smartphone_device_get_power_supply_proxy(_dbus(),
-				FSO_FRAMEWORK_DEVICE_ServiceDBusName,
-				FSO_FRAMEWORK_DEVICE_PowerSupplyServicePath);
-	g_signal_connect(G_OBJECT(fso.power_supply), "capacity",
-			 G_CALLBACK(_capacity_changed_handler), NULL);
-	fso.input = free_smartphone_device_get_input_proxy(_dbus(),
-				FSO_FRAMEWORK_DEVICE_ServiceDBusName,
-				FSO_FRAMEWORK_DEVICE_InputServicePath);
-	g_signal_connect(G_OBJECT(fso.input), "event",
-			 G_CALLBACK(_device_input_event_handler), NULL);
-	fso.idle_notifier = free_smartphone_device_get_idle_notifier_proxy(_dbus(),
-				FSO_FRAMEWORK_DEVICE_ServiceDBusName,
-				FSO_FRAMEWORK_DEVICE_IdleNotifierServicePath);
-	g_signal_connect(G_OBJECT(fso.idle_notifier), "state",
-			 G_CALLBACK(_idle_notifier_handler), NULL);
-	fso.preferences = free_smartphone_get_preferences_proxy(_dbus(),
-				FSO_FRAMEWORK_PREFERENCES_ServiceDBusName,
-				FSO_FRAMEWORK_PREFERENCES_ServicePathPrefix);
-	g_signal_connect(G_OBJECT(fso.preferences), "changed",
-			 G_CALLBACK(_profile_changed_handler), NULL);
-	fso.pim_contacts = free_smartphone_pim_get_contacts_proxy(_dbus(),
-				FSO_FRAMEWORK_PIM_ServiceDBusName,
-				FSO_FRAMEWORK_PIM_ContactsServicePath);
-        g_signal_connect(G_OBJECT(fso.pim_contacts), "new-contact",
-			 G_CALLBACK(_pim_contact_new_handler), NULL);
-	g_signal_connect(G_OBJECT(fso.pim_contacts), "updated-contact",
-			 G_CALLBACK(_pim_contact_updated_handler), NULL);
-	g_signal_connect(G_OBJECT(fso.pim_contacts), "deleted-contact",
-			 G_CALLBACK(_pim_contact_deleted_handler), NULL);
-	fso.pim_messages = free_smartphone_pim_get_messages_proxy(_dbus(),
-				FSO_FRAMEWORK_PIM_ServiceDBusName,
-				FSO_FRAMEWORK_PIM_MessagesServicePath);
-	g_signal_connect(G_OBJECT(fso.pim_messages), "unread-messages",
-			 G_CALLBACK(_pim_unread_messages_handler), NULL);
-	g_signal_connect(G_OBJECT(fso.pim_messages), "new-message",
-			 G_CALLBACK(_pim_message_new_handler), NULL);
-	g_signal_connect(G_OBJECT(fso.pim_messages), "updated-message",
-			 G_CALLBACK(_pim_message_updated_handler), NULL);
-	g_signal_connect(G_OBJECT(fso.pim_messages), "deleted-message",
-			 G_CALLBACK(_pim_message_deleted_handler), NULL);
-	fso.pim_tasks = free_smartphone_pim_get_tasks_proxy(_dbus(),
-				FSO_FRAMEWORK_PIM_ServiceDBusName,
-				FSO_FRAMEWORK_PIM_TasksServicePath);
-	g_signal_connect(G_OBJECT(fso.pim_tasks), "unfinished-tasks",
-			 G_CALLBACK(_pim_unfinished_tasks_handler), NULL);
-        fso.pim_calls = free_smartphone_pim_get_calls_proxy(_dbus(),
-				FSO_FRAMEWORK_PIM_ServiceDBusName,
-				FSO_FRAMEWORK_PIM_CallsServicePath);
-	g_signal_connect(G_OBJECT(fso.pim_calls), "new-missed-calls",
-			 G_CALLBACK(_pim_missed_calls_handler), NULL);
-	g_signal_connect(G_OBJECT(fso.pim_calls), "new-call",
-			 G_CALLBACK(_pim_new_call_handler), NULL);
+	/* the FSO proxies and their signals get set up with the first
+	 * subscriber of an event (see _subscriptions_connect) */
 
 	return 0;
 }
@@ -285,34 +863,40 @@ phoneui_info_init()
 void
 phoneui_info_deinit()
 {
+	int i;
+
 	/*FIXME: find out how to correctly clean up dbus proxies and the connection itself */
 	dbus_g_connection_unref(_dbus());
 
-	callbacks_list_free(callbacks_contact_changes);
-
-	callbacks_list_free(callbacks_message_changes);
-
-	callbacks_list_free(callbacks_call_changes);
-
-	callbacks_list_free(callbacks_profile_changes);
-
-	callbacks_list_free(callbacks_capacity_changes);
-
-	callbacks_list_free(callbacks_missed_calls);
-
-	callbacks_list_free(callbacks_unread_messages);
-
-	callbacks_list_free(callbacks_resource_changes);
-
-	callbacks_list_free(callbacks_network_status);
-
-	callbacks_list_free(callbacks_pdp_context_status);
-
-	callbacks_list_free(callbacks_signal_strength);
+	for (i = 0; all_subscriptions[i]; i++) {
+		_subscriptions_clear(all_subscriptions[i]);
+	}
+	if (single_contact_changes) {
+		GHashTableIter iter;
+		gpointer pack;
+
+		g_hash_table_iter_init(&iter, single_contact_changes);
+		while (g_hash_table_iter_next(&iter, NULL, &pack)) {
+			struct _single_pim_changes_pack *p = pack;
+			if (p->callbacks.dispatching) {
+				/* its dispatch releases it when done */
+				_subscriptions_clear(&p->callbacks);
+				continue;
+			}
+			g_hash_table_iter_remove(&iter);
+			_single_pim_changes_free(pack);
+		}
+		if (!g_hash_table_size(single_contact_changes)) {
+			g_hash_table_destroy(single_contact_changes);
+			single_contact_changes = NULL;
+		}
+	}
 
-	callbacks_list_free(callbacks_input_events);
+	_cache_invalidate(NULL);
 
-	callbacks_list_free(callbacks_call_status);
+	_coalesce_reset(&coalesce_signal_strength);
+	_coalesce_reset(&coalesce_capacity);
+	_coalesce_reset(&coalesce_network_status);
 }
 
 void
@@ -330,46 +914,47 @@ struct _resource_status_request_pack {
 	struct _cb_resource_changes_pack pack;
 };
 
+struct _resource_snapshot_pack {
+	void (*callback)(void *, GHashTable *);
+	void *data;
+	GHashTable *resources;
+	int pending;
+};
 
-void
+struct _resource_snapshot_request_pack {
+	char *resource;
+	struct _resource_snapshot_pack *snapshot;
+};
+
+
+int
 phoneui_info_register_contact_changes(void (*callback)(void *, const char*,
 				enum PhoneuiInfoChangeType), void *data)
 {
-	GList *l;
+	struct _cb_pim_changes_pack pack;
 
 	if (!callback) {
-		g_debug("Not registering an empty callback - fix your code");
-		return;
-	}
-	struct _cb_pim_changes_pack *pack =
-			malloc(sizeof(struct _cb_pim_changes_pack));
-	if (!pack) {
-		g_warning("Failed allocating callback pack - not registering");
-		return;
-	}
-	pack->callback = callback;
-	pack->data = data;
-	l = g_list_append(callbacks_contact_changes, pack);
-	if (!l) {
-		g_warning("Failed to register callback for contact changes");
-	}
-	else {
-		if (!callbacks_contact_changes) {
-			callbacks_contact_changes = l;
-			g_debug("Registered a callback for contact changes");
-		}
+		g_debug("Not registering an empty callback (contact changes)");
+		return 0;
 	}
+	pack.callback = callback;
+	pack.data = data;
+	return _subscriptions_add(&callbacks_contact_changes, &pack, "contact changes");
 }
 
-void
+int
 phoneui_info_register_single_contact_changes(int entryid, void (*callback)(void *, int,
 					enum PhoneuiInfoChangeType), void *data)
 {
 	struct _single_pim_changes_pack *pack = NULL;
-	struct _cb_pim_single_changes_pack *cbpack = NULL;
-	GList *l;
+	struct _cb_pim_single_changes_pack cbpack;
 	char *path;
 
+	if (!callback) {
+		g_debug("Not registering an empty callback (contact %d)", entryid);
+		return 0;
+	}
+
 	if (single_contact_changes) {
 		pack = g_hash_table_lookup(single_contact_changes, &entryid);
 	}
@@ -377,27 +962,20 @@ phoneui_info_register_single_contact_changes(int entryid, void (*callback)(void
 		single_contact_changes = g_hash_table_new(g_int_hash, g_int_equal);
 	}
 
-	cbpack = malloc(sizeof(*cbpack));
-	if (!cbpack) {
-		g_warning("Failed allocating cb pack for changes of contact %d - Not registering", entryid);
-		return;
-	}
-	cbpack->callback = callback;
-	cbpack->data = data;
 	if (!pack) {
 		pack = malloc(sizeof(*pack));
 		if (!pack) {
 			g_warning("Failed allocating pack for single PIM contact changes!");
-			free(cbpack);
-			return;
+			return 0;
 		}
 		path = phoneui_utils_contact_get_dbus_path(entryid);
 		if (!path) {
-			free(cbpack);
-			return;
+			free(pack);
+			return 0;
 		}
 		pack->entryid = entryid;
-		pack->callbacks = NULL;
+		memset(&pack->callbacks, 0, sizeof(pack->callbacks));
+		pack->callbacks.size = sizeof(struct _cb_pim_single_changes_pack);
 		pack->proxy = G_OBJECT(free_smartphone_pim_get_contact_proxy
 				(_dbus(), FSO_FRAMEWORK_PIM_ServiceDBusName, path));
 		g_signal_connect(pack->proxy, "contact-updated",
@@ -411,23 +989,16 @@ phoneui_info_register_single_contact_changes(int entryid, void (*callback)(void
 		free(path);
 	}
 
-	l = g_list_append(pack->callbacks, cbpack);
-	if (!l) {
-		g_warning("Failed to register callback for changes of contact %d", entryid);
-	}
-	else {
-		if (!pack->callbacks) {
-			pack->callbacks = l;
-		}
-		g_debug("Registered a callback for changes of contact %d", entryid);
-	}
+	cbpack.callback = callback;
+	cbpack.data = data;
+	return _subscriptions_add(&pack->callbacks, &cbpack, "contact changes");
 }
 
 void
 phoneui_info_unregister_single_contact_changes(int entryid,
 			void (*callback)(void *, int, enum PhoneuiInfoChangeType))
 {
-	GList *cb;
+	guint i;
 	struct _single_pim_changes_pack *pack;
 	struct _cb_pim_single_changes_pack *cbpack;
 
@@ -436,340 +1007,248 @@ phoneui_info_unregister_single_contact_changes(int entryid,
 		return;
 	}
 	pack = g_hash_table_lookup(single_contact_changes, &entryid);
-	if (!pack) {
+	if (!pack || !pack->callbacks.packs) {
 		g_debug("No one registered for changes of contact %d - Nothing to unregister", entryid);
 		return;
 	}
 
-	for (cb = g_list_first(pack->callbacks); cb; cb = g_list_next(cb)) {
-		cbpack = cb->data;
-		g_debug("comparing a callback");
-		if ((void *)cbpack->callback == (void *)callback) {
-			pack->callbacks = g_list_remove(pack->callbacks, cbpack);
-			g_debug("Removed callback for Contact %d", entryid);
-			if (!pack->callbacks) {
-				g_debug("Was the last one - releasing the Contact proxy for %d", entryid);
-				g_object_unref(pack->proxy);
-				free(pack);
-				g_hash_table_remove(single_contact_changes,
-						    &entryid);
-			}
+	for (i = 0; i < pack->callbacks.packs->len; i++) {
+		cbpack = &g_array_index(pack->callbacks.packs,
+				struct _cb_pim_single_changes_pack, i);
+		if (cbpack->handle && cbpack->callback == callback) {
+			phoneui_info_unregister(cbpack->handle);
 			return;
 		}
 	}
 	g_debug("Callback not found for contact %d", entryid);
 }
 
-void
+int
 phoneui_info_register_message_changes(void (*callback)(void *, const char*,
 				enum PhoneuiInfoChangeType), void *data)
 {
-	GList *l;
+	struct _cb_pim_changes_pack pack;
 
 	if (!callback) {
-		g_debug("Not registering an empty callback - fix your code");
-		return;
-	}
-	struct _cb_pim_changes_pack *pack =
-			malloc(sizeof(struct _cb_pim_changes_pack));
-	if (!pack) {
-		g_warning("Failed allocating callback pack - not registering");
-		return;
-	}
-	pack->callback = callback;
-	pack->data = data;
-	l = g_list_append(callbacks_message_changes, pack);
-	if (!l) {
-		g_warning("Failed to register callback for message changes");
-	}
-	else {
-		if (!callbacks_message_changes) {
-			callbacks_message_changes = l;
-			g_debug("Registered a callback for message changes");
-		}
+		g_debug("Not registering an empty callback (message changes)");
+		return 0;
 	}
+	pack.callback = callback;
+	pack.data = data;
+	return _subscriptions_add(&callbacks_message_changes, &pack, "message changes");
 }
 
-void
+int
 phoneui_info_register_call_changes(void (*callback)(void *, const char *,
 				enum PhoneuiInfoChangeType), void *data)
 {
-	GList *l;
+	struct _cb_pim_changes_pack pack;
 
 	if (!callback) {
-		g_debug("Not registering an empty callback - fix your code");
-		return;
-	}
-	struct _cb_pim_changes_pack *pack =
-			malloc(sizeof(struct _cb_pim_changes_pack));
-	if (!pack) {
-		g_warning("Failed allocating callback pack - not registering");
-		return;
-	}
-	pack->callback = callback;
-	pack->data = data;
-	l = g_list_append(callbacks_call_changes, pack);
-	if (!l) {
-		g_warning("Failed to register callback for call changes");
-	}
-	else {
-		if (!callbacks_call_changes) {
-			callbacks_call_changes = l;
-			g_debug("Registered a callback for call changes");
-		}
+		g_debug("Not registering an empty callback (call changes)");
+		return 0;
 	}
+	pack.callback = callback;
+	pack.data = data;
+	return _subscriptions_add(&callbacks_call_changes, &pack, "call changes");
 }
 
-void phoneui_info_register_call_status_changes(void (*callback)(void *, int,
+int
+phoneui_info_register_call_status_changes(void (*callback)(void *, int,
 						GHashTable *), void* data)
 {
-	GList *l;
+	struct _cb_int_hashtable_pack pack;
 
 	if (!callback) {
-		g_debug("Not registering an empty callback (call status)");
-		return;
-	}
-	struct _cb_int_hashtable_pack *pack =
-		malloc(sizeof(struct _cb_int_hashtable_pack));
-	if (!pack) {
-		g_warning("Failed allocating callback pack (call status)");
-		return;
-	}
-	pack->callback = callback;
-	pack->data = data;
-	l = g_list_append(callbacks_call_status, pack);
-	if (!l) {
-		g_warning("Failed to register callback for call status");
-	}
-	else {
-		if (!callbacks_call_status) {
-			callbacks_call_status = l;
-		}
-		g_debug("Registered a callback for call status");
+		g_debug("Not registering an empty callback (call status)");
+		return 0;
 	}
+	pack.callback = callback;
+	pack.data = data;
+	return _subscriptions_add(&callbacks_call_status, &pack, "call status");
 }
 
-void
+int
 phoneui_info_register_profile_changes(void (*callback)(void *, const char *),
 				      void *data)
 {
-	GList *l;
+	struct _cb_charp_pack pack;
 
 	if (!callback) {
 		g_debug("Not registering an empty callback (profile changes)");
-		return;
-	}
-	struct _cb_charp_pack *pack =
-			malloc(sizeof(struct _cb_charp_pack));
-	if (!pack) {
-		g_warning("Failed allocating callback pack (profile changes)");
-		return;
-	}
-	pack->callback = callback;
-	pack->data = data;
-	l = g_list_append(callbacks_profile_changes, pack);
-	if (!l) {
-		g_warning("Failed to register callback for profile changes");
-	}
-	else {
-		if (!callbacks_profile_changes) {
-			callbacks_profile_changes = l;
-			g_debug("Registered a callback for profile changes");
-		}
+		return 0;
 	}
+	pack.callback = callback;
+	pack.data = data;
+	return _subscriptions_add(&callbacks_profile_changes, &pack, "profile changes");
 }
 
 void
 phoneui_info_request_profile(void (*callback)(void *, const char *), void *data)
 {
+	if (cache.profile) {
+		struct _cb_cached_charp_pack *cached = malloc(sizeof(*cached));
+		cached->callback = callback;
+		cached->data = data;
+		cached->value = strdup(cache.profile);
+		g_idle_add(_cached_charp_idle, cached);
+		return;
+	}
+
 	struct _cb_charp_pack *pack = malloc(sizeof(struct _cb_charp_pack));
 	pack->callback = callback;
 	pack->data = data;
-	free_smartphone_preferences_get_profile(fso.preferences,
+	free_smartphone_preferences_get_profile(_fso_proxy(&fso.preferences),
 						_get_profile_callback, pack);
 }
 
-void
+int
 phoneui_info_register_and_request_profile_changes(void (*callback)(void *, const char *),
 					  void *data)
 {
-	phoneui_info_register_profile_changes(callback, data);
+	int handle;
+
+	handle = phoneui_info_register_profile_changes(callback, data);
 	phoneui_info_request_profile(callback, data);
+	return handle;
 }
 
-void
+int
 phoneui_info_register_capacity_changes(void (*callback)(void *, int),
 				       void *data)
 {
-	GList *l;
+	struct _cb_int_pack pack;
 
 	if (!callback) {
 		g_debug("Not registering an empty callback (capacity changes)");
-		return;
-	}
-	struct _cb_int_pack *pack =
-			malloc(sizeof(struct _cb_int_pack));
-	if (!pack) {
-		g_warning("Failed allocating callback pack (capacity changes)");
-		return;
-	}
-	pack->callback = callback;
-	pack->data = data;
-	l = g_list_append(callbacks_capacity_changes, pack);
-	if (!l) {
-		g_warning("Failed to register callback for capacity changes");
-	}
-	else {
-		if (!callbacks_capacity_changes) {
-			callbacks_capacity_changes = l;
-			g_debug("Registered a callback for capacity changes");
-		}
+		return 0;
 	}
+	pack.callback = callback;
+	pack.data = data;
+	return _subscriptions_add(&callbacks_capacity_changes, &pack, "capacity changes");
 }
 
 void
 phoneui_info_request_capacity(void (*callback)(void *, int), void *data)
 {
+	if (cache.capacity_valid) {
+		_cached_int_deliver(callback, data, cache.capacity);
+		return;
+	}
+
 	struct _cb_int_pack *pack = malloc(sizeof(struct _cb_int_pack));
 	pack->callback = callback;
 	pack->data = data;
-	free_smartphone_device_power_supply_get_capacity(fso.power_supply,
+	free_smartphone_device_power_supply_get_capacity(_fso_proxy(&fso.power_supply),
 			(GAsyncReadyCallback) _get_capacity_callback, pack);
 }
 
-void
+int
 phoneui_info_register_and_request_capacity_changes(void (*callback)(void *, int),
 						   void *data)
 {
-	phoneui_info_register_capacity_changes(callback, data);
+	int handle;
+
+	handle = phoneui_info_register_capacity_changes(callback, data);
 	phoneui_info_request_capacity(callback, data);
+	return handle;
 }
 
 
-void
+int
 phoneui_info_register_missed_calls(void (*callback)(void *, int),
 				   void *data)
 {
-	GList *l;
+	struct _cb_int_pack pack;
 
 	if (!callback) {
 		g_debug("Not registering an empty callback (missed calls)");
-		return;
-	}
-	struct _cb_int_pack *pack =
-			malloc(sizeof(struct _cb_int_pack));
-	if (!pack) {
-		g_warning("Failed allocating callback pack (missed calls)");
-		return;
-	}
-	pack->callback = callback;
-	pack->data = data;
-	l = g_list_append(callbacks_missed_calls, pack);
-	if (!l) {
-		g_warning("Failed to register callback for missed calls");
-	}
-	else {
-		if (!callbacks_missed_calls) {
-			callbacks_missed_calls = l;
-			g_debug("Registered a callback for missed calls");
-		}
+		return 0;
 	}
+	pack.callback = callback;
+	pack.data = data;
+	return _subscriptions_add(&callbacks_missed_calls, &pack, "missed calls");
 }
 
 void
 phoneui_info_request_missed_calls(void (*callback)(void *, int), void *data)
 {
+	if (cache.missed_calls_valid) {
+		_cached_int_deliver(callback, data, cache.missed_calls);
+		return;
+	}
+
 	struct _cb_int_pack *pack = malloc(sizeof(struct _cb_int_pack));
 	pack->callback = callback;
 	pack->data = data;
-	free_smartphone_pim_calls_get_new_missed_calls(fso.pim_calls,
+	free_smartphone_pim_calls_get_new_missed_calls(_fso_proxy(&fso.pim_calls),
 			(GAsyncReadyCallback)_pim_missed_calls_callback, pack);
 }
 
-void
+int
 phoneui_info_register_and_request_missed_calls(void (*callback)(void *, int),
 					       void *data)
 {
-	phoneui_info_register_missed_calls(callback, data);
+	int handle;
+
+	handle = phoneui_info_register_missed_calls(callback, data);
 	phoneui_info_request_missed_calls(callback, data);
+	return handle;
 }
 
-void
+int
 phoneui_info_register_unread_messages(void (*callback)(void *, int),
 				      void *data)
 {
-	GList *l;
+	struct _cb_int_pack pack;
 
 	if (!callback) {
 		g_debug("Not registering an empty callback (unread messages)");
-		return;
-	}
-	struct _cb_int_pack *pack =
-			malloc(sizeof(struct _cb_int_pack));
-	if (!pack) {
-		g_warning("Failed allocating callback pack (unread messages)");
-		return;
-	}
-	pack->callback = callback;
-	pack->data = data;
-	l = g_list_append(callbacks_unread_messages, pack);
-	if (!l) {
-		g_warning("Failed to register callback for unread messages");
-	}
-	else {
-		if (!callbacks_unread_messages) {
-			callbacks_unread_messages = l;
-			g_debug("Registered a callback for unread messages");
-		}
+		return 0;
 	}
+	pack.callback = callback;
+	pack.data = data;
+	return _subscriptions_add(&callbacks_unread_messages, &pack, "unread messages");
 }
 
 void
 phoneui_info_request_unread_messages(void (*callback)(void *, int), void *data)
 {
+	if (cache.unread_messages_valid) {
+		_cached_int_deliver(callback, data, cache.unread_messages);
+		return;
+	}
+
 	struct _cb_int_pack *pack = malloc(sizeof(struct _cb_int_pack));
 	pack->callback = callback;
 	pack->data = data;
-	free_smartphone_pim_messages_get_unread_messages(fso.pim_messages,
+	free_smartphone_pim_messages_get_unread_messages(_fso_proxy(&fso.pim_messages),
 		(GAsyncReadyCallback)_pim_unread_messages_callback, pack);
 }
 
-void
+int
 phoneui_info_register_and_request_unread_messages(void (*callback)(void *, int),
 						  void *data)
 {
-	phoneui_info_register_unread_messages(callback, data);
+	int handle;
+
+	handle = phoneui_info_register_unread_messages(callback, data);
 	phoneui_info_request_unread_messages(callback, data);
+	return handle;
 }
 
-void
+int
 phoneui_info_register_unfinished_tasks(void (*callback)(void *, int), void *data)
 {
-	GList *l;
+	struct _cb_int_pack pack;
 
 	if (!callback) {
 		g_debug("Not registering an empty callback (unfinished tasks)");
-		return;
-	}
-	struct _cb_int_pack *pack =
-			malloc(sizeof(struct _cb_int_pack));
-	if (!pack) {
-		g_warning("Failed allocating callback pack (unfinished tasks)");
-		return;
-	}
-	pack->callback = callback;
-	pack->data = data;
-	l = g_list_append(callbacks_unfinished_tasks, pack);
-	if (!l) {
-		g_warning("Failed to register callback for unfinished tasks");
-	}
-	else {
-		if (!callbacks_unfinished_tasks) {
-			callbacks_unfinished_tasks = l;
-			g_debug("Registered a callback for unfinished tasks");
-		}
+		return 0;
 	}
-
+	pack.callback = callback;
+	pack.data = data;
+	return _subscriptions_add(&callbacks_unfinished_tasks, &pack, "unfinished tasks");
 }
 
 void
@@ -784,44 +1263,32 @@ phoneui_info_request_unfinished_tasks(void (*callback)(void *, int), void *data)
 	opimd_tasks_get_unfinished_tasks(_unfinished_tasks_callback, pack);*/
 }
 
-void
+int
 phoneui_info_register_and_request_unfinished_tasks(void (*callback)(void *, int),
 						   void *data)
 {
-	phoneui_info_register_unfinished_tasks(callback, data);
+	int handle;
+
+	handle = phoneui_info_register_unfinished_tasks(callback, data);
 	phoneui_info_request_unfinished_tasks(callback, data);
+	return handle;
 }
 
 
 
-void
+int
 phoneui_info_register_resource_status(void (*callback)(void *, const char *,
 					gboolean, GHashTable *), void *data)
 {
-	GList *l;
+	struct _cb_resource_changes_pack pack;
 
 	if (!callback) {
 		g_debug("Not registering an empty callback (resource changes)");
-		return;
-	}
-	struct _cb_resource_changes_pack *pack =
-			malloc(sizeof(struct _cb_resource_changes_pack));
-	if (!pack) {
-		g_warning("Failed allocating callback pack (resource changes)");
-		return;
-	}
-	pack->callback = callback;
-	pack->data = data;
-	l = g_list_append(callbacks_resource_changes, pack);
-	if (!l) {
-		g_warning("Failed to register callback for resource changes");
-	}
-	else {
-		if (!callbacks_resource_changes) {
-			callbacks_resource_changes = l;
-			g_debug("Registered a callback for resource changes");
-		}
+		return 0;
 	}
+	pack.callback = callback;
+	pack.data = data;
+	return _subscriptions_add(&callbacks_resource_changes, &pack, "resource changes");
 }
 
 void
@@ -833,98 +1300,102 @@ phoneui_info_request_resource_status(void (*callback)(void *, const char *,
 			malloc(sizeof(struct _cb_resource_changes_pack));
 	pack->callback = callback;
 	pack->data = data;
-	free_smartphone_usage_list_resources(fso.usage,
+	free_smartphone_usage_list_resources(_fso_proxy(&fso.usage),
 			(GAsyncReadyCallback)_list_resources_callback, pack);
 }
 
 void
+phoneui_info_request_resource_snapshot(void (*callback)(void *, GHashTable *),
+				       void *data)
+{
+	struct _resource_snapshot_pack *pack;
+
+	if (!callback) {
+		g_debug("Not requesting a resource snapshot without callback");
+		return;
+	}
+	pack = malloc(sizeof(*pack));
+	pack->callback = callback;
+	pack->data = data;
+	pack->resources = NULL;
+	pack->pending = 0;
+	free_smartphone_usage_list_resources(_fso_proxy(&fso.usage),
+			(GAsyncReadyCallback)_list_resources_snapshot_callback, pack);
+}
+
+int
 phoneui_info_register_and_request_resource_status(void (*callback)(void *,
 				const char *, gboolean, GHashTable *), void *data)
 {
-	phoneui_info_register_resource_status(callback, data);
+	int handle;
+
+	handle = phoneui_info_register_resource_status(callback, data);
 	phoneui_info_request_resource_status(callback, data);
+	return handle;
 }
 
 
-void
+int
 phoneui_info_register_network_status(void (*callback)(void *, GHashTable *),
 				     void *data)
 {
-	GList *l;
+	struct _cb_hashtable_pack pack;
 
 	if (!callback) {
 		g_debug("Not registering an empty callback (network status)");
-		return;
-	}
-	struct _cb_hashtable_pack *pack =
-			malloc(sizeof(struct _cb_hashtable_pack));
-	if (!pack) {
-		g_warning("Failed allocating callback pack (network status)");
-		return;
-	}
-	pack->callback = callback;
-	pack->data = data;
-	l = g_list_append(callbacks_network_status, pack);
-	if (!l) {
-		g_warning("Failed to register callback for network status");
-	}
-	else {
-		if (!callbacks_network_status) {
-			callbacks_network_status = l;
-			g_debug("Registered a callback for network status");
-		}
+		return 0;
 	}
+	pack.callback = callback;
+	pack.data = data;
+	return _subscriptions_add(&callbacks_network_status, &pack, "network status");
 }
 
 void
 phoneui_info_request_network_status(void (*callback)(void *, GHashTable *),
 				    void *data)
 {
+	if (cache.network_status) {
+		struct _cb_cached_hashtable_pack *cached = malloc(sizeof(*cached));
+		cached->callback = callback;
+		cached->data = data;
+		cached->value = g_hash_table_ref(cache.network_status);
+		g_idle_add(_cached_hashtable_idle, cached);
+		return;
+	}
+
 	struct _cb_hashtable_pack *pack =
 			malloc(sizeof(struct _cb_hashtable_pack));
 	pack->callback = callback;
 	pack->data = data;
-	free_smartphone_gsm_network_get_status(fso.gsm_network,
+	free_smartphone_gsm_network_get_status(_fso_proxy(&fso.gsm_network),
 			(GAsyncReadyCallback)_get_network_status_callback, pack);
 }
 
-void
+int
 phoneui_info_register_and_request_network_status(void (*callback)(void *,
 						 GHashTable *), void *data)
 {
-	phoneui_info_register_network_status(callback, data);
+	int handle;
+
+	handle = phoneui_info_register_network_status(callback, data);
 	phoneui_info_request_network_status(callback, data);
+	return handle;
 }
 
-void
+int
 phoneui_info_register_pdp_context_status(void (*callback)(void *,
 					FreeSmartphoneGSMContextStatus,
 					GHashTable *), void *data)
 {
-	GList *l;
+	struct _cb_gsm_context_status_pack pack;
 
 	if (!callback) {
 		g_debug("Not registering an empty callback (pdp context status)");
-		return;
-	}
-	struct _cb_gsm_context_status_pack *pack =
-			malloc(sizeof(struct _cb_gsm_context_status_pack));
-	if (!pack) {
-		g_warning("Failed allocating callback pack (pdp context status)");
-		return;
-	}
-	pack->callback = callback;
-	pack->data = data;
-	l = g_list_append(callbacks_pdp_context_status, pack);
-	if (!l) {
-		g_warning("Failed to register callback for pdp context status");
-	}
-	else {
-		if (!callbacks_pdp_context_status) {
-			callbacks_pdp_context_status = l;
-			g_debug("Registered a callback for pdp context status");
-		}
+		return 0;
 	}
+	pack.callback = callback;
+	pack.data = data;
+	return _subscriptions_add(&callbacks_pdp_context_status, &pack, "pdp context status");
 }
 
 void
@@ -936,93 +1407,74 @@ phoneui_info_request_pdp_context_status(void (*callback)(void *,
 			malloc(sizeof(struct _cb_gsm_context_status_pack));
 	pack->callback = callback;
 	pack->data = data;
-	free_smartphone_gsm_pdp_get_context_status(fso.gsm_pdp,
+	free_smartphone_gsm_pdp_get_context_status(_fso_proxy(&fso.gsm_pdp),
 					_get_pdp_context_status_callback, pack);
 }
 
-void
+int
 phoneui_info_register_and_request_pdp_context_status(void (*callback)(void *,
 		FreeSmartphoneGSMContextStatus, GHashTable *), void *data)
 {
-	phoneui_info_register_pdp_context_status(callback, data);
+	int handle;
+
+	handle = phoneui_info_register_pdp_context_status(callback, data);
 	phoneui_info_request_pdp_context_status(callback, data);
+	return handle;
 }
 
-void
+int
 phoneui_info_register_signal_strength(void (*callback)(void *, int),
 				      void *data)
 {
-	GList *l;
+	struct _cb_int_pack pack;
 
 	if (!callback) {
 		g_debug("Not registering an empty callback (signal strength)");
-		return;
-	}
-	struct _cb_int_pack *pack =
-			malloc(sizeof(struct _cb_int_pack));
-	if (!pack) {
-		g_warning("Failed allocating callback pack (signal strength)");
-		return;
-	}
-	pack->callback = callback;
-	pack->data = data;
-	l = g_list_append(callbacks_signal_strength, pack);
-	if (!l) {
-		g_warning("Failed to register callback for signal strength");
-	}
-	else {
-		if (!callbacks_signal_strength) {
-			callbacks_signal_strength = l;
-			g_debug("Registered a callback for signal strength");
-		}
+		return 0;
 	}
+	pack.callback = callback;
+	pack.data = data;
+	return _subscriptions_add(&callbacks_signal_strength, &pack, "signal strength");
 }
 
 void
 phoneui_info_request_signal_strength(void (*callback)(void *, int), void *data)
 {
+	if (cache.signal_strength_valid) {
+		_cached_int_deliver(callback, data, cache.signal_strength);
+		return;
+	}
+
 	struct _cb_int_pack *pack = malloc(sizeof(struct _cb_int_pack));
 	pack->callback = callback;
 	pack->data = data;
-	free_smartphone_gsm_network_get_signal_strength(fso.gsm_network,
+	free_smartphone_gsm_network_get_signal_strength(_fso_proxy(&fso.gsm_network),
 		(GAsyncReadyCallback)_get_signal_strength_callback, pack);
 }
 
-void
+int
 phoneui_info_register_and_request_signal_strength(void (*callback)(void *, int), void *data)
 {
-	phoneui_info_register_signal_strength(callback, data);
+	int handle;
+
+	handle = phoneui_info_register_signal_strength(callback, data);
 	phoneui_info_request_signal_strength(callback, data);
+	return handle;
 }
 
-void
+int
 phoneui_info_register_input_events(void (*callback)(void *, const char *,
 			FreeSmartphoneDeviceInputState, int), void *data)
 {
-	GList *l;
+	struct _cb_input_event_pack pack;
 
 	if (!callback) {
 		g_debug("Not registering an empty callback (input events)");
-		return;
-	}
-	struct _cb_input_event_pack *pack =
-			malloc(sizeof(struct _cb_input_event_pack));
-	if (!pack) {
-		g_warning("Failed allocating callback pack (input events)");
-		return;
-	}
-	pack->callback = callback;
-	pack->data = data;
-	l = g_list_append(callbacks_input_events, pack);
-	if (!l) {
-		g_warning("Failed to register callback for input events");
-	}
-	else {
-		if (!callbacks_input_events) {
-			callbacks_input_events = l;
-			g_debug("Registered a callback for input events");
-		}
+		return 0;
 	}
+	pack.callback = callback;
+	pack.data = data;
+	return _subscriptions_add(&callbacks_input_events, &pack, "input events");
 }
 
 /* --- signal handlers --- */
@@ -1033,7 +1485,9 @@ _pim_missed_calls_handler(GObject* source, int amount, gpointer data)
 	(void) source;
 	(void) data;
 	g_debug("_missed_calls_handler: %d missed calls", amount);
-	_execute_int_callbacks(callbacks_missed_calls, amount);
+	cache.missed_calls = amount;
+	cache.missed_calls_valid = _subscriptions_connected(&callbacks_missed_calls);
+	_execute_int_callbacks(&callbacks_missed_calls, amount);
 }
 
 static void
@@ -1041,7 +1495,7 @@ _pim_new_call_handler(GObject *source, char *path, gpointer data)
 {
 	(void) source;
 	(void) data;
-	_execute_pim_changed_callbacks(callbacks_call_changes,
+	_execute_pim_changed_callbacks(&callbacks_call_changes,
 				       path, PHONEUI_INFO_CHANGE_NEW);
 }
 
@@ -1051,7 +1505,9 @@ _pim_unread_messages_handler(GObject* source, int amount, gpointer data)
 	(void) source;
 	(void) data;
 	g_debug("_unread_messages_handler: %d unread messages", amount);
-	_execute_int_callbacks(callbacks_unread_messages, amount);
+	cache.unread_messages = amount;
+	cache.unread_messages_valid = _subscriptions_connected(&callbacks_unread_messages);
+	_execute_int_callbacks(&callbacks_unread_messages, amount);
 }
 
 static void
@@ -1060,7 +1516,7 @@ _pim_unfinished_tasks_handler(GObject* source, int amount, gpointer data)
 	(void) source;
 	(void) data;
 	g_debug("_unfinished_tasks_handler: %d unfinished tasks", amount);
-	_execute_int_callbacks(callbacks_unfinished_tasks, amount);
+	_execute_int_callbacks(&callbacks_unfinished_tasks, amount);
 }
 
 static void
@@ -1071,7 +1527,7 @@ _resource_changed_handler(GObject *source, char *resource, gboolean state,
 	(void) data;
 	g_debug("_resource_changed_handler: %s is now %s",
 			resource, state ? "enabled" : "disabled");
-	_execute_resource_callbacks(callbacks_resource_changes, resource,
+	_execute_resource_callbacks(&callbacks_resource_changes, resource,
 				    state, properties);
 }
 
@@ -1082,7 +1538,7 @@ _call_status_handler(GObject *source, int callid,
 {
 	(void) source;
 	(void) data;
-	_execute_int_hashtable_callbacks(callbacks_call_status, state, properties);
+	_execute_int_hashtable_callbacks(&callbacks_call_status, state, properties);
 	g_debug("_call_status_handler: call %d: %d", callid, state);
 }
 
@@ -1092,7 +1548,8 @@ _profile_changed_handler(GObject* source, const char* profile, gpointer data)
 	(void) source;
 	(void) data;
 	g_debug("_profile_changed_handler: active profile is %s", profile);
-	_execute_charp_callbacks(callbacks_profile_changes, profile);
+	_cache_set_profile(profile);
+	_execute_charp_callbacks(&callbacks_profile_changes, profile);
 }
 
 //static void _alarm_changed_handler(const int time)
@@ -1107,7 +1564,10 @@ _capacity_changed_handler(GObject* source, int energy, gpointer data)
 	(void) source;
 	(void) data;
 	g_debug("_capacity_changed_handler: capacity is %d", energy);
-	_execute_int_callbacks(callbacks_capacity_changes, energy);
+	cache.capacity = energy;
+	cache.capacity_valid = _subscriptions_connected(&callbacks_capacity_changes);
+	coalesce_capacity.value = energy;
+	_coalesce_push(&coalesce_capacity);
 }
 
 static void
@@ -1115,7 +1575,13 @@ _network_status_handler(GObject* source, GHashTable* properties, gpointer data)
 {
 	(void) source;
 	(void) data;
-	_execute_hashtable_callbacks(callbacks_network_status, properties);
+	_cache_set_network_status(properties);
+	if (coalesce_network_status.properties) {
+		g_hash_table_unref(coalesce_network_status.properties);
+	}
+	coalesce_network_status.properties =
+			(properties) ? g_hash_table_ref(properties) : NULL;
+	_coalesce_push(&coalesce_network_status);
 }
 
 static void
@@ -1126,7 +1592,7 @@ _pdp_context_status_handler(GObject *source,
 	(void) source;
 	(void) data;
 	_execute_gsm_context_status_callbacks
-			(callbacks_pdp_context_status, status, properties);
+			(&callbacks_pdp_context_status, status, properties);
 }
 
 static void
@@ -1135,15 +1601,10 @@ _signal_strength_handler(GObject* source, int signal, gpointer data)
 	(void) source;
 	(void) data;
 	g_debug("_signal_strength_handler: %d", signal);
-	_execute_int_callbacks(callbacks_signal_strength, signal);
-}
-
-static void
-_idle_notifier_handler(GObject* source, int state, gpointer data)
-{
-	(void) source;
-	(void) data;
-	g_debug("_idle_notifier_handler: idle state now %d", state);
+	cache.signal_strength = signal;
+	cache.signal_strength_valid = _subscriptions_connected(&callbacks_signal_strength);
+	coalesce_signal_strength.value = signal;
+	_coalesce_push(&coalesce_signal_strength);
 }
 
 static void
@@ -1152,7 +1613,7 @@ _pim_contact_new_handler(GObject* source, const char* path, gpointer data)
 	(void) source;
 	(void) data;
 	g_debug("New contact %s got added", path);
-	_execute_pim_changed_callbacks(callbacks_contact_changes,
+	_execute_pim_changed_callbacks(&callbacks_contact_changes,
 				       path, PHONEUI_INFO_CHANGE_NEW);
 }
 
@@ -1164,7 +1625,7 @@ _pim_contact_updated_handler(GObject* source, const char* path,
 	(void) data;
 	(void) content;
 	g_debug("Contact %s got updated", path);
-	_execute_pim_changed_callbacks(callbacks_contact_changes,
+	_execute_pim_changed_callbacks(&callbacks_contact_changes,
 				       path, PHONEUI_INFO_CHANGE_UPDATE);
 }
 
@@ -1174,7 +1635,7 @@ _pim_contact_deleted_handler(GObject* source, const char* path, gpointer data)
 	(void) source;
 	(void) data;
 	g_debug("Contact %s got deleted", path);
-	_execute_pim_changed_callbacks(callbacks_contact_changes,
+	_execute_pim_changed_callbacks(&callbacks_contact_changes,
 				       path, PHONEUI_INFO_CHANGE_DELETE);
 }
 
@@ -1197,8 +1658,9 @@ _pim_single_contact_updated_handler(GObject *source, GHashTable *content,
 		g_warning("No listener for changes of PIM Contact %d", entryid);
 		return;
 	}
-	_execute_pim_single_changed_callbacks(pack->callbacks, entryid,
+	_execute_pim_single_changed_callbacks(&pack->callbacks, entryid,
 					      PHONEUI_INFO_CHANGE_UPDATE);
+	_single_pim_changes_release_unused(pack);
 }
 
 static void
@@ -1219,8 +1681,9 @@ _pim_single_contact_deleted_handler(GObject *source, gpointer data)
 		g_warning("No listener for changes of PIM Contact %d", entryid);
 		return;
 	}
-	_execute_pim_single_changed_callbacks(pack->callbacks, entryid,
+	_execute_pim_single_changed_callbacks(&pack->callbacks, entryid,
 					      PHONEUI_INFO_CHANGE_DELETE);
+	_single_pim_changes_release_unused(pack);
 }
 
 static void
@@ -1229,7 +1692,7 @@ _pim_message_new_handler(GObject* source, const char* path, gpointer data)
 	(void) source;
 	(void) data;
 	g_debug("New message %s got added", path);
-	_execute_pim_changed_callbacks(callbacks_message_changes,
+	_execute_pim_changed_callbacks(&callbacks_message_changes,
 				       path, PHONEUI_INFO_CHANGE_NEW);
 }
 
@@ -1241,7 +1704,7 @@ _pim_message_updated_handler(GObject* source, const char* path,
 	(void) data;
 	(void) content;
 	g_debug("Message %s got updated", path);
-	_execute_pim_changed_callbacks(callbacks_message_changes,
+	_execute_pim_changed_callbacks(&callbacks_message_changes,
 				       path, PHONEUI_INFO_CHANGE_UPDATE);
 }
 
@@ -1251,7 +1714,7 @@ _pim_message_deleted_handler(GObject* source, const char* path, gpointer data)
 	(void) source;
 	(void) data;
 	g_debug("Message %s got deleted", path);
-	_execute_pim_changed_callbacks(callbacks_message_changes,
+	_execute_pim_changed_callbacks(&callbacks_message_changes,
 				       path, PHONEUI_INFO_CHANGE_DELETE);
 }
 
@@ -1262,7 +1725,7 @@ _device_input_event_handler(GObject* source, char* input_source,
 {
 	(void) source;
 	(void) data;
-	_execute_input_event_callbacks(callbacks_input_events,
+	_execute_input_event_callbacks(&callbacks_input_events,
 				input_source, action, duration);
 }
 
@@ -1271,18 +1734,20 @@ _device_input_event_handler(GObject* source, char* input_source,
 static void
 _pim_missed_calls_callback(GObject *source, GAsyncResult *res, gpointer data)
 {
-	(void) source;
 	GError *error = NULL;
 	int amount;
 
 	amount = free_smartphone_pim_calls_get_new_missed_calls_finish
-				(fso.pim_calls, res, &error);
+				((gpointer) source, res, &error);
+	g_object_unref(source);
 	if (error) {
 		g_message("_missed_calls_callback: error %d: %s",
 				error->code, error->message);
 		g_error_free(error);
 		return;
 	}
+	cache.missed_calls = amount;
+	cache.missed_calls_valid = _subscriptions_connected(&callbacks_missed_calls);
 	if (data) {
 		struct _cb_int_pack *pack = data;
 		pack->callback(pack->data, amount);
@@ -1293,18 +1758,20 @@ _pim_missed_calls_callback(GObject *source, GAsyncResult *res, gpointer data)
 static void
 _pim_unread_messages_callback(GObject *source, GAsyncResult *res, gpointer data)
 {
-	(void) source;
 	GError *error = NULL;
 	int amount;
 
 	amount = free_smartphone_pim_messages_get_unread_messages_finish
-					(fso.pim_messages, res, &error);
+					((gpointer) source, res, &error);
+	g_object_unref(source);
 	if (error) {
 		g_message("_unread_messages_callback: error %d: %s",
 				error->code, error->message);
 		g_error_free(error);
 		return;
 	}
+	cache.unread_messages = amount;
+	cache.unread_messages_valid = _subscriptions_connected(&callbacks_unread_messages);
 	if (data) {
 		struct _cb_int_pack *pack = data;
 		pack->callback(pack->data, amount);
@@ -1332,23 +1799,24 @@ _pim_unread_messages_callback(GObject *source, GAsyncResult *res, gpointer data)
 static void
 _list_resources_callback(GObject *source, GAsyncResult *res, gpointer data)
 {
-	(void) source;
 	GError *error = NULL;
 	char **resources;
 	int count;
 
-	resources = free_smartphone_usage_get_resource_users_finish
-					(fso.usage, res, &count, &error);
+	resources = free_smartphone_usage_list_resources_finish
+					((gpointer) source, res, &count, &error);
 	struct _resource_status_request_pack *pack;
 	struct _cb_resource_changes_pack *packpack;
 
+	packpack = data;
 	if (error) {
 		g_message("_list_resources_callback: error %d: %s",
 				error->code, error->message);
 		g_error_free(error);
+		g_object_unref(source);
+		free(packpack);
 		return;
 	}
-	packpack = data;
 	if (resources) {
 		int i = 0;
 		while (resources[i] != NULL) {
@@ -1356,68 +1824,163 @@ _list_resources_callback(GObject *source, GAsyncResult *res, gpointer data)
 			pack->resource = resources[i];
 			pack->pack.callback = packpack->callback;
 			pack->pack.data = packpack->data;
-			free_smartphone_usage_get_resource_state(fso.usage,
+			free_smartphone_usage_get_resource_state(_fso_proxy(&fso.usage),
 				resources[i], _resource_state_callback, pack);
 			i++;
 		}
+		/* the strings are owned by the request packs now */
+		g_free(resources);
 	}
+	g_object_unref(source);
 	free(packpack);
 }
 
 static void
 _resource_state_callback(GObject *source, GAsyncResult *res, gpointer data)
 {
-	(void) source;
 	GError *error = NULL;
 	gboolean state;
 
 	state = free_smartphone_usage_get_resource_state_finish
-						(fso.usage, res, &error);
+						((gpointer) source, res, &error);
+	g_object_unref(source);
+	struct _resource_status_request_pack *pack = data;
+
 	if (error) {
 		g_message("_resource_state_callback: error %d: %s",
 				error->code, error->message);
 		g_error_free(error);
-		return;
 	}
-	if (data) {
-		struct _resource_status_request_pack *pack = data;
+	else {
 		pack->pack.callback(pack->pack.data, pack->resource, state, NULL);
-		// FIXME: do we have to free pack->resource ???
-		free(pack);
+	}
+	g_free(pack->resource);
+	free(pack);
+}
+
+static void
+_resource_snapshot_done(struct _resource_snapshot_pack *pack)
+{
+	g_debug("Resource snapshot done: %d resources",
+		pack->resources ? g_hash_table_size(pack->resources) : 0);
+	pack->callback(pack->data, pack->resources);
+	if (pack->resources) {
+		g_hash_table_unref(pack->resources);
+	}
+	free(pack);
+}
+
+static void
+_list_resources_snapshot_callback(GObject *source, GAsyncResult *res,
+				  gpointer data)
+{
+	GError *error = NULL;
+	char **resources;
+	int count = 0, i;
+	struct _resource_snapshot_pack *pack = data;
+	struct _resource_snapshot_request_pack *request;
+
+	resources = free_smartphone_usage_list_resources_finish
+					((gpointer) source, res, &count, &error);
+	if (error) {
+		g_message("_list_resources_snapshot_callback: error %d: %s",
+				error->code, error->message);
+		g_error_free(error);
+		g_object_unref(source);
+		_resource_snapshot_done(pack);
+		return;
+	}
+
+	pack->resources = g_hash_table_new_full(g_str_hash, g_str_equal,
+						g_free, _helpers_free_gvalue);
+	if (!resources || !resources[0]) {
+		g_free(resources);
+		g_object_unref(source);
+		_resource_snapshot_done(pack);
+		return;
+	}
+
+	/* fire all state requests at once, the snapshot gets delivered
+	 * when the last reply came in */
+	for (i = 0; resources[i]; i++) {
+		pack->pending++;
+	}
+	for (i = 0; resources[i]; i++) {
+		request = malloc(sizeof(*request));
+		request->resource = resources[i];
+		request->snapshot = pack;
+		free_smartphone_usage_get_resource_state(_fso_proxy(&fso.usage),
+			resources[i], _resource_snapshot_state_callback, request);
+	}
+	g_free(resources);
+	g_object_unref(source);
+}
+
+static void
+_resource_snapshot_state_callback(GObject *source, GAsyncResult *res,
+				  gpointer data)
+{
+	GError *error = NULL;
+	gboolean state;
+	struct _resource_snapshot_request_pack *request = data;
+	struct _resource_snapshot_pack *pack = request->snapshot;
+
+	state = free_smartphone_usage_get_resource_state_finish
+						((gpointer) source, res, &error);
+	g_object_unref(source);
+	if (error) {
+		/* leave it out of the snapshot */
+		g_message("_resource_snapshot_state_callback: %s: error %d: %s",
+			  request->resource, error->code, error->message);
+		g_error_free(error);
+		g_free(request->resource);
+	}
+	else {
+		g_hash_table_insert(pack->resources, request->resource,
+				    _helpers_new_gvalue_boolean(state));
+	}
+	free(request);
+
+	if (--pack->pending == 0) {
+		_resource_snapshot_done(pack);
 	}
 }
 
 static void
 _get_profile_callback(GObject *source, GAsyncResult *res, gpointer data)
 {
-	(void) source;
 	GError *error = NULL;
 	char *profile;
 
 	profile = free_smartphone_preferences_get_profile_finish
-						(fso.preferences, res, &error);
+						((gpointer) source, res, &error);
+	g_object_unref(source);
 	if (error) {
 		g_message("_get_profile_callback: error %d: %s",
 				error->code, error->message);
 		g_error_free(error);
 		return;
 	}
+	if (_subscriptions_connected(&callbacks_profile_changes)) {
+		_cache_set_profile(profile);
+	}
 	if (data) {
 		struct _cb_charp_pack *pack = data;
 		pack->callback(pack->data, profile);
 		free(pack);
 	}
+	g_free(profile);
 }
 
 static void
 _get_capacity_callback(GObject *source, GAsyncResult *res, gpointer data)
 {
-	(void) source;
 	GError *error = NULL;
 	int energy;
 
 	energy = free_smartphone_device_power_supply_get_capacity_finish
-						(fso.power_supply, res, &error);
+						((gpointer) source, res, &error);
+	g_object_unref(source);
 
 	if (error) {
 		g_message("_get_capacity_callback: error %d: %s",
@@ -1425,6 +1988,8 @@ _get_capacity_callback(GObject *source, GAsyncResult *res, gpointer data)
 		g_error_free(error);
 		return;
 	}
+	cache.capacity = energy;
+	cache.capacity_valid = _subscriptions_connected(&callbacks_capacity_changes);
 	if (data) {
 		struct _cb_int_pack *pack = data;
 		pack->callback(pack->data, energy);
@@ -1435,12 +2000,12 @@ _get_capacity_callback(GObject *source, GAsyncResult *res, gpointer data)
 static void
 _get_network_status_callback(GObject *source, GAsyncResult *res, gpointer data)
 {
-	(void) source;
 	GError *error = NULL;
 	GHashTable *properties = NULL;
 
 	properties = free_smartphone_gsm_network_get_status_finish
-					(fso.gsm_network, res, &error);
+					((gpointer) source, res, &error);
+	g_object_unref(source);
 	g_debug("_get_network_status_callback");
 	if (error) {
 		g_message("_get_network_status_callback: error %d: %s",
@@ -1448,18 +2013,23 @@ _get_network_status_callback(GObject *source, GAsyncResult *res, gpointer data)
 		g_error_free(error);
 		return;
 	}
+	if (_subscriptions_connected(&callbacks_network_status)) {
+		_cache_set_network_status(properties);
+	}
 	if (data) {
 		struct _cb_hashtable_pack *pack = data;
 		pack->callback(pack->data, properties);
 		free(pack);
 	}
+	if (properties) {
+		g_hash_table_unref(properties);
+	}
 	g_debug("_get_network_status_callback DONE");
 }
 
 static void
 _get_pdp_context_status_callback(GObject *source, GAsyncResult *res, gpointer data)
 {
-	(void) source;
 	GError *error = NULL;
 	FreeSmartphoneGSMContextStatus status;
 	GHashTable *properties = NULL;
@@ -1467,7 +2037,8 @@ _get_pdp_context_status_callback(GObject *source, GAsyncResult *res, gpointer da
 
 	g_debug("_get_pdp_context_status_callback");
 	free_smartphone_gsm_pdp_get_context_status_finish
-				(fso.gsm_pdp, res, &status, &properties, &error);
+				((gpointer) source, res, &status, &properties, &error);
+	g_object_unref(source);
 	if (error) {
 		g_message("_get_pdp_context_status_callback: error %d: %s",
 			  error->code, error->message);
@@ -1488,19 +2059,21 @@ _get_pdp_context_status_callback(GObject *source, GAsyncResult *res, gpointer da
 static void
 _get_signal_strength_callback(GObject *source, GAsyncResult *res, gpointer data)
 {
-	(void) source;
 	GError *error = NULL;
 	int signal;
 
 	g_debug("_get_signal_strength_callback");
 	signal = free_smartphone_gsm_network_get_signal_strength_finish
-						(fso.gsm_network, res, &error);
+						((gpointer) source, res, &error);
+	g_object_unref(source);
 	if (error) {
 		g_message("_get_signal_strength_callback: error %d: %s",
 				error->code, error->message);
 		g_error_free(error);
 		return;
 	}
+	cache.signal_strength = signal;
+	cache.signal_strength_valid = _subscriptions_connected(&callbacks_signal_strength);
 	if (data) {
 		struct _cb_int_pack *pack = data;
 		g_debug("calling signal callback");
@@ -1532,147 +2105,206 @@ _name_owner_changed(DBusGProxy *proxy, const char *name,
 	(void) proxy;
 	(void) new;
 	(void) data;
+	if (prev && *prev && *name != ':') {
+		/* the service went away or got restarted - don't
+		 * keep using the proxies created for the old one */
+		_dbus_proxies_invalidate(name);
+		_subscriptions_rebind(name);
+		_cache_invalidate(name);
+	}
 	if (prev && *prev && !strcmp(name, FSO_FRAMEWORK_GSM_ServiceDBusName)) {
-		_execute_hashtable_callbacks(callbacks_network_status, NULL);
+		_coalesce_reset(&coalesce_signal_strength);
+		_coalesce_reset(&coalesce_network_status);
+		_execute_hashtable_callbacks(&callbacks_network_status, NULL);
 		_execute_gsm_context_status_callbacks
-			(callbacks_pdp_context_status,
+			(&callbacks_pdp_context_status,
 			 FREE_SMARTPHONE_GSM_CONTEXT_STATUS_UNKNOWN, NULL);
-		_execute_int_callbacks(callbacks_signal_strength, 0);
+		_execute_int_callbacks(&callbacks_signal_strength, 0);
 	}
 }
 
-static void _execute_pim_changed_callbacks(GList *cbs, const char *path,
+static void
+_execute_pim_changed_callbacks(struct _subscriptions *cbs, const char *path,
 				       enum PhoneuiInfoChangeType type)
 {
-	GList *cb;
+	guint i, len;
+	struct _cb_pim_changes_pack *pack;
 
-	if (!cbs) {
-		g_debug("No callbacks registered");
+	if (!cbs->packs)
 		return;
-	}
 
-	g_debug("Running all callbacks");
-	for (cb = g_list_first(cbs); cb; cb = g_list_next(cb)) {
-		struct _cb_pim_changes_pack *pack =
-			(struct _cb_pim_changes_pack *)cb->data;
-		pack->callback(pack->data, path, type);
+	/* subscribers registered meanwhile only get the next event */
+	len = cbs->packs->len;
+	_subscriptions_dispatch_begin(cbs);
+	for (i = 0; i < len; i++) {
+		pack = &g_array_index(cbs->packs, struct _cb_pim_changes_pack, i);
+		if (pack->handle)
+			pack->callback(pack->data, path, type);
 	}
+	_subscriptions_dispatch_end(cbs);
 }
 
-static void _execute_pim_single_changed_callbacks(GList *cbs, int entryid,
+static void
+_execute_pim_single_changed_callbacks(struct _subscriptions *cbs, int entryid,
 						  enum PhoneuiInfoChangeType type)
 {
-	GList *cb;
+	guint i, len;
+	struct _cb_pim_single_changes_pack *pack;
 
-	if (!cbs) {
-		g_debug("No callbacks registered");
+	if (!cbs->packs)
 		return;
+
+	/* subscribers registered meanwhile only get the next event */
+	len = cbs->packs->len;
+	_subscriptions_dispatch_begin(cbs);
+	for (i = 0; i < len; i++) {
+		pack = &g_array_index(cbs->packs, struct _cb_pim_single_changes_pack, i);
+		if (pack->handle)
+			pack->callback(pack->data, entryid, type);
 	}
-	for (cb = g_list_first(cbs); cb; cb = g_list_next(cb)) {
-		struct _cb_pim_single_changes_pack *pack = cb->data;
-		pack->callback(pack->data, entryid, type);
-	}
+	_subscriptions_dispatch_end(cbs);
 }
 
 static void
-_execute_int_callbacks(GList *cbs, int value)
+_execute_int_callbacks(struct _subscriptions *cbs, int value)
 {
-	GList *cb;
+	guint i, len;
+	struct _cb_int_pack *pack;
 
-	if (!cbs)
+	if (!cbs->packs)
 		return;
 
-	for (cb = g_list_first(cbs); cb; cb = g_list_next(cb)) {
-		struct _cb_int_pack *pack = (struct _cb_int_pack *)cb->data;
-		pack->callback(pack->data, value);
+	/* subscribers registered meanwhile only get the next event */
+	len = cbs->packs->len;
+	_subscriptions_dispatch_begin(cbs);
+	for (i = 0; i < len; i++) {
+		pack = &g_array_index(cbs->packs, struct _cb_int_pack, i);
+		if (pack->handle)
+			pack->callback(pack->data, value);
 	}
+	_subscriptions_dispatch_end(cbs);
 }
 
 static void
-_execute_input_event_callbacks(GList *cbs, const char *value1,
+_execute_input_event_callbacks(struct _subscriptions *cbs, const char *value1,
 			       FreeSmartphoneDeviceInputState value2, int value3)
 {
-	GList *cb;
-	if (!cbs)
+	guint i, len;
+	struct _cb_input_event_pack *pack;
+
+	if (!cbs->packs)
 		return;
 
-	for (cb = g_list_first(cbs); cb; cb = g_list_next(cb)) {
-		struct _cb_input_event_pack *pack = cb->data;
-		pack->callback(pack->data, value1, value2, value3);
+	/* subscribers registered meanwhile only get the next event */
+	len = cbs->packs->len;
+	_subscriptions_dispatch_begin(cbs);
+	for (i = 0; i < len; i++) {
+		pack = &g_array_index(cbs->packs, struct _cb_input_event_pack, i);
+		if (pack->handle)
+			pack->callback(pack->data, value1, value2, value3);
 	}
+	_subscriptions_dispatch_end(cbs);
 }
 
 static void
-_execute_hashtable_callbacks(GList *cbs, GHashTable *properties)
+_execute_hashtable_callbacks(struct _subscriptions *cbs, GHashTable *properties)
 {
-	GList *cb;
+	guint i, len;
+	struct _cb_hashtable_pack *pack;
 
-	if (!cbs)
+	if (!cbs->packs)
 		return;
 
-	for (cb = g_list_first(cbs); cb; cb = g_list_next(cb)) {
-		struct _cb_hashtable_pack *pack =
-				(struct _cb_hashtable_pack *)cb->data;
-		pack->callback(pack->data, properties);
+	/* subscribers registered meanwhile only get the next event */
+	len = cbs->packs->len;
+	_subscriptions_dispatch_begin(cbs);
+	for (i = 0; i < len; i++) {
+		pack = &g_array_index(cbs->packs, struct _cb_hashtable_pack, i);
+		if (pack->handle)
+			pack->callback(pack->data, properties);
 	}
+	_subscriptions_dispatch_end(cbs);
 }
 
 static void
-_execute_charp_callbacks(GList* cbs, const char* value)
+_execute_charp_callbacks(struct _subscriptions *cbs, const char *value)
 {
-	GList *cb;
+	guint i, len;
+	struct _cb_charp_pack *pack;
 
-	if (!cbs)
+	if (!cbs->packs)
 		return;
 
-	for (cb = g_list_first(cbs); cb; cb = g_list_next(cb)) {
-		struct _cb_charp_pack *pack = (struct _cb_charp_pack *)cb->data;
-		pack->callback(pack->data, value);
+	/* subscribers registered meanwhile only get the next event */
+	len = cbs->packs->len;
+	_subscriptions_dispatch_begin(cbs);
+	for (i = 0; i < len; i++) {
+		pack = &g_array_index(cbs->packs, struct _cb_charp_pack, i);
+		if (pack->handle)
+			pack->callback(pack->data, value);
 	}
+	_subscriptions_dispatch_end(cbs);
 }
 
 static void
-_execute_resource_callbacks(GList *cbs, const char *resource, gboolean state,
+_execute_resource_callbacks(struct _subscriptions *cbs, const char *resource, gboolean state,
 			    GHashTable *properties)
 {
-	GList *cb;
+	guint i, len;
+	struct _cb_resource_changes_pack *pack;
 
-	if (!cbs)
+	if (!cbs->packs)
 		return;
 
-	for (cb = g_list_first(cbs); cb; cb = g_list_next(cb)) {
-		struct _cb_resource_changes_pack *pack =
-				(struct _cb_resource_changes_pack *)cb->data;
-		pack->callback(pack->data, resource, state, properties);
+	/* subscribers registered meanwhile only get the next event */
+	len = cbs->packs->len;
+	_subscriptions_dispatch_begin(cbs);
+	for (i = 0; i < len; i++) {
+		pack = &g_array_index(cbs->packs, struct _cb_resource_changes_pack, i);
+		if (pack->handle)
+			pack->callback(pack->data, resource, state, properties);
 	}
+	_subscriptions_dispatch_end(cbs);
 }
 
 static void
-_execute_int_hashtable_callbacks(GList *cbs, int val1, GHashTable *val2)
+_execute_int_hashtable_callbacks(struct _subscriptions *cbs, int val1, GHashTable *val2)
 {
-	GList *cb;
+	guint i, len;
+	struct _cb_int_hashtable_pack *pack;
 
-	if (!cbs)
+	if (!cbs->packs)
 		return;
 
-	for (cb = g_list_first(cbs); cb; cb = g_list_next(cb)) {
-		struct _cb_int_hashtable_pack *pack = cb->data;
-		pack->callback(pack->data, val1, val2);
+	/* subscribers registered meanwhile only get the next event */
+	len = cbs->packs->len;
+	_subscriptions_dispatch_begin(cbs);
+	for (i = 0; i < len; i++) {
+		pack = &g_array_index(cbs->packs, struct _cb_int_hashtable_pack, i);
+		if (pack->handle)
+			pack->callback(pack->data, val1, val2);
 	}
+	_subscriptions_dispatch_end(cbs);
 }
 
 static void
-_execute_gsm_context_status_callbacks(GList *cbs,
-				   FreeSmartphoneGSMContextStatus val1,
-				   GHashTable *val2)
+_execute_gsm_context_status_callbacks(struct _subscriptions *cbs,
+				      FreeSmartphoneGSMContextStatus val1,
+				      GHashTable *val2)
 {
-	GList *cb;
+	guint i, len;
+	struct _cb_gsm_context_status_pack *pack;
 
-	if (!cbs)
+	if (!cbs->packs)
 		return;
 
-	for (cb = g_list_first(cbs); cb; cb = g_list_next(cb)) {
-		struct _cb_gsm_context_status_pack *pack = cb->data;
-		pack->callback(pack->data, val1, val2);
+	/* subscribers registered meanwhile only get the next event */
+	len = cbs->packs->len;
+	_subscriptions_dispatch_begin(cbs);
+	for (i = 0; i < len; i++) {
+		pack = &g_array_index(cbs->packs, struct _cb_gsm_context_status_pack, i);
+		if (pack->handle)
+			pack->callback(pack->data, val1, val2);
 	}
+	_subscriptions_dispatch_end(cbs);
 }
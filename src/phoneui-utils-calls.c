@@ -81,7 +81,7 @@ phoneui_utils_call_initiate(const char *_number,
 	pack = malloc(sizeof(*pack));
 	pack->callback = callback;
 	pack->data = userdata;
-	pack->call = free_smartphone_gsm_get_call_proxy(_dbus(),
+	pack->call = _DBUS_PROXY(free_smartphone_gsm_get_call_proxy,
 					FSO_FRAMEWORK_GSM_ServiceDBusName,
 					FSO_FRAMEWORK_GSM_DeviceServicePath);
 	number = strdup(_number);
@@ -122,7 +122,7 @@ phoneui_utils_call_release(int call_id, void (*callback)(GError *, gpointer),
 	pack = malloc(sizeof(*pack));
 	pack->callback = callback;
 	pack->data = data;
-	pack->call = free_smartphone_gsm_get_call_proxy(_dbus(),
+	pack->call = _DBUS_PROXY(free_smartphone_gsm_get_call_proxy,
 					FSO_FRAMEWORK_GSM_ServiceDBusName,
 					FSO_FRAMEWORK_GSM_DeviceServicePath);
 	free_smartphone_gsm_call_release(pack->call, call_id,
@@ -157,7 +157,7 @@ phoneui_utils_call_activate(int call_id,
 	pack = malloc(sizeof(*pack));
 	pack->callback = callback;
 	pack->data = data;
-	pack->call = free_smartphone_gsm_get_call_proxy(_dbus(),
+	pack->call = _DBUS_PROXY(free_smartphone_gsm_get_call_proxy,
 					FSO_FRAMEWORK_GSM_ServiceDBusName,
 					FSO_FRAMEWORK_GSM_DeviceServicePath);
 	free_smartphone_gsm_call_activate(pack->call, call_id,
@@ -194,7 +194,7 @@ phoneui_utils_call_send_dtmf(const char *tones,
 	pack = malloc(sizeof(*pack));
 	pack->callback = callback;
 	pack->data = data;
-	pack->call = free_smartphone_gsm_get_call_proxy(_dbus(),
+	pack->call = _DBUS_PROXY(free_smartphone_gsm_get_call_proxy,
 					FSO_FRAMEWORK_GSM_ServiceDBusName,
 					FSO_FRAMEWORK_GSM_DeviceServicePath);
 	free_smartphone_gsm_call_send_dtmf(pack->call, tones,
@@ -280,7 +280,7 @@ phoneui_utils_ussd_initiate(const char *request,
 	pack = malloc(sizeof(*pack));
 	pack->callback = callback;
 	pack->data = data;
-	pack->net = free_smartphone_gsm_get_network_proxy(_dbus(),
+	pack->net = _DBUS_PROXY(free_smartphone_gsm_get_network_proxy,
 					FSO_FRAMEWORK_GSM_ServiceDBusName,
 					FSO_FRAMEWORK_GSM_DeviceServicePath);
 	free_smartphone_gsm_network_send_ussd_request (pack->net, request,
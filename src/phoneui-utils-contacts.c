@@ -34,14 +34,53 @@
 #include "dbus.h"
 #include "phoneui-utils.h"
 #include "phoneui-utils-contacts.h"
+#include "contacts-index.h"
+#include "latency.h"
+#include "cancel.h"
 
 
 struct _query_pack {
 	int *count;
 	void (*callback)(gpointer, gpointer);
+	void (*name_callback)(GHashTable *, const char *, gpointer);
+	void (*record_callback)(struct PhoneuiContact *, gpointer);
+	struct _cancellable *cancellable;
 	gpointer data;
 };
 
+struct _contact_names {
+	const char *name;
+	const char *surname;
+	const char *middlename;
+	const char *nickname;
+	const char *affiliation;
+};
+
+enum _contact_slot {
+	CONTACT_SLOT_PATH,
+	CONTACT_SLOT_NAME,
+	CONTACT_SLOT_SURNAME,
+	CONTACT_SLOT_MIDDLENAME,
+	CONTACT_SLOT_NICKNAME,
+	CONTACT_SLOT_AFFILIATION,
+	CONTACT_SLOT_PHONE,
+	CONTACT_SLOT_DISPLAY_NAME,
+	CONTACT_SLOTS
+};
+
+/* the strings live right behind the struct, in the same allocation */
+struct PhoneuiContact {
+	GHashTable *properties;
+	const char *slots[CONTACT_SLOTS];
+	char strings[];
+};
+
+struct _contact_sort_entry {
+	GHashTable *contact;
+	char *display_name;
+	char *collate_key;
+};
+
 struct _field_type_pack {
 	gpointer data;
 	void (*callback)(GError *, char *, gpointer);
@@ -69,6 +108,8 @@ struct _field_pack {
 struct _contact_lookup_pack {
 	gpointer *data;
 	void (*callback)(GError *, GHashTable *, gpointer);
+	GHashTable *contact;
+	gdouble started;
 };
 
 struct _contact_add_pack {
@@ -91,77 +132,196 @@ struct _contact_pack {
 
 struct _contact_get_pack {
 	FreeSmartphonePIMContact *contact;
+	struct _cancellable *cancellable;
 	gpointer data;
 	void (*callback)(GError *, GHashTable *, gpointer);
 };
 
+static struct PhoneuiContact *_contact_record_new(GHashTable *properties,
+						  const char *display_name);
+
 static int _compare_func(gconstpointer a, gconstpointer b)
 {
-	return phoneui_utils_contact_compare(*((GHashTable **)a), *((GHashTable **)b));
+	const struct _contact_sort_entry *entry1 = a;
+	const struct _contact_sort_entry *entry2 = b;
+
+	/* same order as phoneui_utils_contact_compare, contacts without
+	 * a name come first */
+	if (!entry1->collate_key)
+		return (entry2->collate_key) ? -1 : 0;
+	if (!entry2->collate_key)
+		return 1;
+	return strcmp(entry1->collate_key, entry2->collate_key);
 }
 
-void phoneui_utils_contacts_query(const char *sortby, gboolean sortdesc,
+int phoneui_utils_contacts_query(const char *sortby, gboolean sortdesc,
 			   gboolean disjunction, int limit_start, int limit,
 			   const GHashTable *options,
 			   void (*callback)(GError *, GHashTable **, int, gpointer),
 			   gpointer data)
 {
-	phoneui_utils_pim_query(PHONEUI_PIM_DOMAIN_CONTACTS, sortby, sortdesc,
+	return phoneui_utils_pim_query(PHONEUI_PIM_DOMAIN_CONTACTS, sortby, sortdesc,
 				disjunction, limit_start, limit, FALSE, options,
 				callback, data);
 }
 
-void
+int
 phoneui_utils_contacts_get_full(const char *sortby, gboolean sortdesc,
 			   int limit_start, int limit,
 			   void (*callback)(GError *, GHashTable **, int, gpointer),
 			   gpointer userdata)
 {
-	phoneui_utils_contacts_query(sortby, sortdesc, FALSE, limit_start, limit,
-				NULL, callback, userdata);
+	return phoneui_utils_contacts_query(sortby, sortdesc, FALSE, limit_start,
+				limit, NULL, callback, userdata);
 }
 
 static void
 _contacts_parse(GError *error, GHashTable **messages, int count, gpointer data)
 {
 	int i;
-	GPtrArray *contacts;
+	gdouble start, sort_start;
+	struct _contact_sort_entry *entries;
 	struct _query_pack *pack = data;
 
+	if (_cancellable_cancelled(pack->cancellable)) {
+		_cancel_results_drop(messages, count);
+		goto exit;
+	}
+
 	if (pack->count)
 		*pack->count = count;
 
-	if (error)
+	if (error || count <= 0)
 		goto exit;
 
-	contacts = g_ptr_array_sized_new(count);
+	/* build the display name and its collation key only once per
+	 * contact instead of on every comparison */
+	entries = malloc(count * sizeof(*entries));
+	if (!entries)
+		goto exit;
+
+	start = _latency_begin();
+	for (i = 0; i < count; i++) {
+		entries[i].contact = messages[i];
+		entries[i].display_name =
+			phoneui_utils_contact_display_name_get(messages[i]);
+		entries[i].collate_key = (entries[i].display_name) ?
+			g_utf8_collate_key(entries[i].display_name, -1) : NULL;
+	}
 
-	for (i = 0; i < count; i++)
-		g_ptr_array_add(contacts, messages[i]);
+	_latency_end(start, "contact display name", count);
 
-	g_ptr_array_sort(contacts, _compare_func);
-	g_ptr_array_foreach(contacts, pack->callback, pack->data);
-	g_ptr_array_unref(contacts);
+	sort_start = _latency_begin();
+	qsort(entries, count, sizeof(*entries), _compare_func);
+	_latency_end(sort_start, "contacts sort", 1);
+	_latency_end(sort_start, "contacts sort per contact", count);
+
+	for (i = 0; i < count; i++) {
+		/* a callback might have cancelled the rest */
+		if (_cancellable_cancelled(pack->cancellable)) {
+			g_hash_table_unref(entries[i].contact);
+		}
+		else if (pack->record_callback) {
+			/* the record takes over the reference */
+			struct PhoneuiContact *record = _contact_record_new
+				(entries[i].contact, entries[i].display_name);
+			if (record)
+				pack->record_callback(record, pack->data);
+		}
+		else if (pack->name_callback) {
+			pack->name_callback(entries[i].contact,
+					entries[i].display_name, pack->data);
+		}
+		else if (pack->callback) {
+			pack->callback(entries[i].contact, pack->data);
+		}
+		free(entries[i].display_name);
+		g_free(entries[i].collate_key);
+	}
+	free(entries);
 
 exit:
+	_cancellable_free(pack->cancellable);
 	free(pack);
 }
 
-void
+static int
+_contacts_get(struct _query_pack *pack)
+{
+	int handle;
+
+	if (pack->count)
+		*pack->count = 0;
+
+	/* the query has its own handle, this one drops what it delivers */
+	pack->cancellable = _cancellable_new();
+	if (!pack->cancellable) {
+		free(pack);
+		return 0;
+	}
+	handle = pack->cancellable->handle;
+	/* 0 means the query won't call back */
+	if (!phoneui_utils_contacts_get_full(NULL, FALSE, 0, -1,
+					     _contacts_parse, pack)) {
+		_cancellable_free(pack->cancellable);
+		free(pack);
+		return 0;
+	}
+	return handle;
+}
+
+int
 phoneui_utils_contacts_get(int *count,
 			   void (*callback)(gpointer, gpointer),
 			   gpointer userdata)
 {
 	struct _query_pack *pack;
 	pack = malloc(sizeof(*pack));
+	if (!pack)
+		return 0;
 	pack->callback = callback;
+	pack->name_callback = NULL;
+	pack->record_callback = NULL;
 	pack->data = userdata;
 	pack->count = count;
 
-	if (count)
-		*count = 0;
+	return _contacts_get(pack);
+}
 
-	phoneui_utils_contacts_get_full(NULL, FALSE, 0, -1, _contacts_parse, pack);
+int
+phoneui_utils_contacts_get_with_names(int *count,
+		void (*callback)(GHashTable *, const char *, gpointer),
+		gpointer userdata)
+{
+	struct _query_pack *pack;
+	pack = malloc(sizeof(*pack));
+	if (!pack)
+		return 0;
+	pack->callback = NULL;
+	pack->name_callback = callback;
+	pack->record_callback = NULL;
+	pack->data = userdata;
+	pack->count = count;
+
+	return _contacts_get(pack);
+}
+
+int
+phoneui_utils_contacts_get_records(int *count,
+		void (*callback)(struct PhoneuiContact *, gpointer),
+		gpointer userdata)
+{
+	struct _query_pack *pack;
+	pack = malloc(sizeof(*pack));
+	if (!pack)
+		return 0;
+	pack->callback = NULL;
+	pack->name_callback = NULL;
+	pack->record_callback = callback;
+	pack->data = userdata;
+	pack->count = count;
+
+	return _contacts_get(pack);
 }
 
 static void
@@ -197,7 +357,7 @@ phoneui_utils_contacts_field_type_get(const char *name,
 	pack = malloc(sizeof(*pack));
 	pack->callback = callback;
 	pack->data = data;
-	pack->fields = free_smartphone_pim_get_fields_proxy(_dbus(),
+	pack->fields = _DBUS_PROXY(free_smartphone_pim_get_fields_proxy,
 					FSO_FRAMEWORK_PIM_ServiceDBusName,
 					FSO_FRAMEWORK_PIM_ContactsServicePath);
 	free_smartphone_pim_fields_get_type_(pack->fields, name,
@@ -253,7 +413,7 @@ phoneui_utils_contacts_fields_get(void (*callback)(GError *, GHashTable *, gpoin
 	pack = malloc(sizeof(*pack));
 	pack->callback = callback;
 	pack->data = data;
-	pack->fields = free_smartphone_pim_get_fields_proxy(_dbus(),
+	pack->fields = _DBUS_PROXY(free_smartphone_pim_get_fields_proxy,
 					FSO_FRAMEWORK_PIM_ServiceDBusName,
 					FSO_FRAMEWORK_PIM_ContactsServicePath);
 	free_smartphone_pim_fields_list_fields(pack->fields,
@@ -291,7 +451,7 @@ phoneui_utils_contacts_fields_get_with_type(const char *type,
 			malloc(sizeof(struct _fields_with_type_pack));
 	pack->data = data;
 	pack->callback = callback;
-	pack->fields = free_smartphone_pim_get_fields_proxy(_dbus(),
+	pack->fields = _DBUS_PROXY(free_smartphone_pim_get_fields_proxy,
 					FSO_FRAMEWORK_PIM_ServiceDBusName,
 					FSO_FRAMEWORK_PIM_ContactsServicePath);
 	free_smartphone_pim_fields_list_fields_with_type(pack->fields, type,
@@ -322,7 +482,7 @@ phoneui_utils_contacts_field_add(const char *name, const char *type,
 	pack = malloc(sizeof(*pack));
 	pack->callback = callback;
 	pack->data = data;
-	pack->fields = free_smartphone_pim_get_fields_proxy(_dbus(),
+	pack->fields = _DBUS_PROXY(free_smartphone_pim_get_fields_proxy,
 					FSO_FRAMEWORK_PIM_ServiceDBusName,
 					FSO_FRAMEWORK_PIM_ContactsServicePath);
 
@@ -354,7 +514,7 @@ phoneui_utils_contacts_field_remove(const char *name,
 	pack = malloc(sizeof(*pack));
 	pack->callback = callback;
 	pack->data = data;
-	pack->fields = free_smartphone_pim_get_fields_proxy(_dbus(),
+	pack->fields = _DBUS_PROXY(free_smartphone_pim_get_fields_proxy,
 					FSO_FRAMEWORK_PIM_ServiceDBusName,
 					FSO_FRAMEWORK_PIM_ContactsServicePath);
 	free_smartphone_pim_fields_delete_field(pack->fields, name,
@@ -369,6 +529,7 @@ _contact_lookup_callback(GError *error, GHashTable **messages, int count, gpoint
 	GValue *tmp;
 	const char *path;
 
+	_latency_end(pack->started, "contact lookup query", 1);
 	if (count != 1 || !(tmp = g_hash_table_lookup(messages[0], "Path")) || error) {
 		pack->callback(error, NULL, pack->data);
 		return;
@@ -381,6 +542,19 @@ _contact_lookup_callback(GError *error, GHashTable **messages, int count, gpoint
 	free(pack);
 }
 
+static gboolean
+_contact_lookup_cached(gpointer data)
+{
+	struct _contact_lookup_pack *pack = data;
+
+	_latency_end(pack->started, "contact lookup cached", 1);
+	pack->callback(NULL, pack->contact, pack->data);
+	g_hash_table_unref(pack->contact);
+	free(pack);
+
+	return FALSE;
+}
+
 int
 phoneui_utils_contact_lookup(const char *number,
 			void (*callback)(GError *, GHashTable *, gpointer),
@@ -399,9 +573,16 @@ phoneui_utils_contact_lookup(const char *number,
 	pack = malloc(sizeof(*pack));
 	pack->callback = callback;
 	pack->data = data;
+	pack->started = _latency_begin();
 
-	query = g_hash_table_new_full(g_str_hash, g_str_equal,
-		NULL, _helpers_free_gvalue);
+	/* known locally - no need to ask opimd */
+	pack->contact = _contacts_index_lookup(number);
+	if (pack->contact) {
+		g_idle_add(_contact_lookup_cached, pack);
+		return 0;
+	}
+
+	query = _helpers_new_field_table();
 
 	value = _helpers_new_gvalue_string(number);
 	if (!value) {
@@ -412,7 +593,7 @@ phoneui_utils_contact_lookup(const char *number,
 		return 1;
 	}
 
-	g_hash_table_insert(query, "$phonenumber", value);
+	g_hash_table_insert(query, _helpers_field("$phonenumber"), value);
 	phoneui_utils_contacts_query(NULL, FALSE, FALSE, 0, 1, query,
 				_contact_lookup_callback, pack);
 
@@ -481,10 +662,11 @@ _contact_get_callback(GError *error, GHashTable *contact, gpointer data)
 {
 	struct _contact_get_pack *pack = data;
 
-	if (pack->callback) {
+	if (pack->callback && !_cancellable_cancelled(pack->cancellable)) {
 		pack->callback(error, contact, pack->data);
 	}
 
+	_cancellable_free(pack->cancellable);
 	free(pack);
 }
 
@@ -496,6 +678,7 @@ phoneui_utils_contact_get(const char *contact_path,
 	struct _contact_get_pack *pack;
 
 	pack = malloc(sizeof(*pack));
+	pack->cancellable = NULL;
 	pack->callback = callback;
 	pack->data = data;
 
@@ -503,27 +686,62 @@ phoneui_utils_contact_get(const char *contact_path,
 	return 0;
 }
 
-void
+int
+phoneui_utils_contact_get_cancellable(const char *contact_path,
+			  void (*callback)(GError *, GHashTable *, gpointer),
+			  gpointer data)
+{
+	int handle;
+	struct _contact_get_pack *pack;
+
+	pack = malloc(sizeof(*pack));
+	if (!pack)
+		return 0;
+	pack->cancellable = _cancellable_new();
+	if (!pack->cancellable) {
+		free(pack);
+		return 0;
+	}
+	handle = pack->cancellable->handle;
+	pack->callback = callback;
+	pack->data = data;
+
+	/* the call itself can't be aborted, only its result dropped */
+	opimd_contact_get_content(contact_path, _contact_get_callback, pack);
+	return handle;
+}
+
+int
 phoneui_utils_contact_get_fields_for_type(const char* contact_path,
 					  const char* type,
 					  void (*callback)(GError *, GHashTable *, gpointer),
 					  void *data)
 {
+	int handle;
 	struct _contact_get_pack *pack;
 
+	pack = malloc(sizeof(*pack));
+	if (!pack)
+		return 0;
+	pack->cancellable = _cancellable_new();
+	if (!pack->cancellable) {
+		free(pack);
+		return 0;
+	}
+	handle = pack->cancellable->handle;
 	char *_type = calloc(sizeof(char), strlen(type)+2);
 	_type[0] = '$';
 	strcat(_type, type);
-	pack = malloc(sizeof(*pack));
 	pack->data = data;
 	pack->callback = callback;
 	opimd_contact_get_multiple_fields(contact_path, _type,
 					  _contact_get_callback, pack);
 	free(_type);
+	return handle;
 }
 
-char *
-phoneui_utils_contact_display_phone_get(GHashTable *properties)
+static const char *
+_contact_phone_find(GHashTable *properties)
 {
 	const char *phone = NULL;
 	gpointer _key, _val;
@@ -573,19 +791,30 @@ phoneui_utils_contact_display_phone_get(GHashTable *properties)
 		}
 	}
 
+	return phone;
+}
+
+char *
+phoneui_utils_contact_display_phone_get(GHashTable *properties)
+{
+	const char *phone = _contact_phone_find(properties);
+
 	return (phone) ? strdup(phone) : NULL;
 }
 
 char *
-phoneui_utils_contact_display_name_get(GHashTable *properties)
+phoneui_utils_contact_lookup_name(const char *number)
+{
+	return _contacts_index_lookup_name(number);
+}
+
+static void
+_contact_names_find(GHashTable *properties, struct _contact_names *names)
 {
 	gpointer _key, _val;
-	const char *name = NULL, *surname = NULL;
-	const char *middlename = NULL, *nickname = NULL;
-	const char *affiliation = NULL;
-	char *displayname = NULL;
 	GHashTableIter iter;
 
+	memset(names, 0, sizeof(*names));
 	g_hash_table_iter_init(&iter, properties);
 	while (g_hash_table_iter_next(&iter, &_key, &_val)) {
 		const char *key = (const char *)_key;
@@ -597,25 +826,30 @@ phoneui_utils_contact_display_name_get(GHashTable *properties)
 		}
 
 		if (!strcmp(key, "Name")) {
-			const char *s_val = g_value_get_string(val);
-			name = s_val;
+			names->name = g_value_get_string(val);
 		}
 		else if (!strcmp(key, "Surname")) {
-			const char *s_val = g_value_get_string(val);
-			surname = s_val;
+			names->surname = g_value_get_string(val);
 		}
 		else if (!strcmp(key, "Middlename")) {
-			const char *s_val = g_value_get_string(val);
-			middlename = s_val;
+			names->middlename = g_value_get_string(val);
 		}
 		else if (!strcmp(key, "Nickname")) {
-			const char *s_val = g_value_get_string(val);
-			nickname = s_val;
+			names->nickname = g_value_get_string(val);
 		}
 		else if (!strcmp(key, "Affiliation")) {
-			affiliation = g_value_get_string(val);
+			names->affiliation = g_value_get_string(val);
 		}
 	}
+}
+
+static char *
+_contact_display_name_build(const struct _contact_names *names)
+{
+	const char *name = names->name, *surname = names->surname;
+	const char *middlename = names->middlename, *nickname = names->nickname;
+	const char *affiliation = names->affiliation;
+	char *displayname = NULL;
 
 	/* construct some sane display name from the fields */
 	if (name && nickname && surname && affiliation) {
@@ -667,6 +901,144 @@ phoneui_utils_contact_display_name_get(GHashTable *properties)
 	return displayname;
 }
 
+char *
+phoneui_utils_contact_display_name_get(GHashTable *properties)
+{
+	struct _contact_names names;
+
+	_contact_names_find(properties, &names);
+	return _contact_display_name_build(&names);
+}
+
+static struct PhoneuiContact *
+_contact_record_new(GHashTable *properties, const char *display_name)
+{
+	int i;
+	size_t len;
+	char *p, *built = NULL;
+	const GValue *tmp;
+	struct _contact_names names;
+	struct PhoneuiContact *contact;
+	const char *fields[CONTACT_SLOTS];
+
+	_contact_names_find(properties, &names);
+	if (!display_name) {
+		built = _contact_display_name_build(&names);
+		display_name = built;
+	}
+	tmp = g_hash_table_lookup(properties, "Path");
+
+	fields[CONTACT_SLOT_PATH] = (tmp && G_VALUE_HOLDS_STRING(tmp)) ?
+			g_value_get_string(tmp) : NULL;
+	fields[CONTACT_SLOT_NAME] = names.name;
+	fields[CONTACT_SLOT_SURNAME] = names.surname;
+	fields[CONTACT_SLOT_MIDDLENAME] = names.middlename;
+	fields[CONTACT_SLOT_NICKNAME] = names.nickname;
+	fields[CONTACT_SLOT_AFFILIATION] = names.affiliation;
+	fields[CONTACT_SLOT_PHONE] = _contact_phone_find(properties);
+	fields[CONTACT_SLOT_DISPLAY_NAME] = display_name;
+
+	len = 0;
+	for (i = 0; i < CONTACT_SLOTS; i++) {
+		if (fields[i])
+			len += strlen(fields[i]) + 1;
+	}
+
+	contact = malloc(sizeof(*contact) + len);
+	if (!contact) {
+		g_free(built);
+		g_hash_table_unref(properties);
+		return NULL;
+	}
+	contact->properties = properties;
+
+	p = contact->strings;
+	for (i = 0; i < CONTACT_SLOTS; i++) {
+		if (!fields[i]) {
+			contact->slots[i] = NULL;
+			continue;
+		}
+		len = strlen(fields[i]) + 1;
+		memcpy(p, fields[i], len);
+		contact->slots[i] = p;
+		p += len;
+	}
+	g_free(built);
+
+	return contact;
+}
+
+struct PhoneuiContact *
+phoneui_utils_contact_record_new(GHashTable *properties)
+{
+	if (!properties)
+		return NULL;
+	return _contact_record_new(g_hash_table_ref(properties), NULL);
+}
+
+void
+phoneui_utils_contact_record_free(struct PhoneuiContact *contact)
+{
+	if (!contact)
+		return;
+	g_hash_table_unref(contact->properties);
+	free(contact);
+}
+
+const char *
+phoneui_utils_contact_record_path(const struct PhoneuiContact *contact)
+{
+	return contact->slots[CONTACT_SLOT_PATH];
+}
+
+const char *
+phoneui_utils_contact_record_name(const struct PhoneuiContact *contact)
+{
+	return contact->slots[CONTACT_SLOT_NAME];
+}
+
+const char *
+phoneui_utils_contact_record_surname(const struct PhoneuiContact *contact)
+{
+	return contact->slots[CONTACT_SLOT_SURNAME];
+}
+
+const char *
+phoneui_utils_contact_record_middlename(const struct PhoneuiContact *contact)
+{
+	return contact->slots[CONTACT_SLOT_MIDDLENAME];
+}
+
+const char *
+phoneui_utils_contact_record_nickname(const struct PhoneuiContact *contact)
+{
+	return contact->slots[CONTACT_SLOT_NICKNAME];
+}
+
+const char *
+phoneui_utils_contact_record_affiliation(const struct PhoneuiContact *contact)
+{
+	return contact->slots[CONTACT_SLOT_AFFILIATION];
+}
+
+const char *
+phoneui_utils_contact_record_phone(const struct PhoneuiContact *contact)
+{
+	return contact->slots[CONTACT_SLOT_PHONE];
+}
+
+const char *
+phoneui_utils_contact_record_display_name(const struct PhoneuiContact *contact)
+{
+	return contact->slots[CONTACT_SLOT_DISPLAY_NAME];
+}
+
+GHashTable *
+phoneui_utils_contact_record_properties(const struct PhoneuiContact *contact)
+{
+	return contact->properties;
+}
+
 int
 phoneui_utils_contact_compare(GHashTable *contact1, GHashTable *contact2)
 {
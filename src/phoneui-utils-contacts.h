@@ -24,9 +24,16 @@
 
 #include <glib.h>
 
-void phoneui_utils_contacts_query(const char *sortby, gboolean sortdesc, gboolean disjunction, int limit_start, int limit, const GHashTable *options, void (*callback)(GError *, GHashTable **, int, gpointer), gpointer data);
-void phoneui_utils_contacts_get_full(const char *sortby, gboolean sortdesc, int limit_start, int limit, void (*callback)(GError *, GHashTable **, int, gpointer), gpointer data);
-void phoneui_utils_contacts_get(int *count, void (*callback)(gpointer , gpointer), gpointer data);
+int phoneui_utils_contacts_query(const char *sortby, gboolean sortdesc, gboolean disjunction, int limit_start, int limit, const GHashTable *options, void (*callback)(GError *, GHashTable **, int, gpointer), gpointer data);
+int phoneui_utils_contacts_get_full(const char *sortby, gboolean sortdesc, int limit_start, int limit, void (*callback)(GError *, GHashTable **, int, gpointer), gpointer data);
+/* these return a handle for phoneui_utils_cancel, 0 if they couldn't start */
+int phoneui_utils_contacts_get(int *count, void (*callback)(gpointer , gpointer), gpointer data);
+/* like phoneui_utils_contacts_get, the display name is only valid during the callback */
+int phoneui_utils_contacts_get_with_names(int *count, void (*callback)(GHashTable *, const char *, gpointer), gpointer data);
+/* like phoneui_utils_contacts_get, but hands out compact records - free
+ * them with phoneui_utils_contact_record_free */
+struct PhoneuiContact;
+int phoneui_utils_contacts_get_records(int *count, void (*callback)(struct PhoneuiContact *, gpointer), gpointer data);
 void phoneui_utils_contacts_field_type_get(const char *name, void (*callback)(GError *, char *, gpointer), gpointer user_data);
 void phoneui_utils_contacts_fields_get(void (*callback)(GError *, GHashTable *, gpointer), gpointer data);
 void phoneui_utils_contacts_fields_get_with_type(const char *type, void (*callback)(GError *, char **, int, gpointer), gpointer data);
@@ -35,16 +42,36 @@ void phoneui_utils_contacts_field_remove(const char *name, void (*callback)(GErr
 
 
 int phoneui_utils_contact_lookup(const char *_number, void (*_callback) (GError *, GHashTable *, gpointer), gpointer data);
+/* synchronous, only knows the contacts already in the local index - NULL otherwise */
+char *phoneui_utils_contact_lookup_name(const char *number);
 int phoneui_utils_contact_delete(const char *path, void (*name_callback) (GError *, gpointer), gpointer data);
 int phoneui_utils_contact_update(const char *path, GHashTable *contact_data, void (*callback)(GError *, gpointer), gpointer data);
 int phoneui_utils_contact_add(GHashTable *contact_data, void (*callback)(GError*, char *, gpointer), gpointer data);
 int phoneui_utils_contact_get(const char *contact_path, void (*callback)(GError *, GHashTable*, gpointer), gpointer data);
-void phoneui_utils_contact_get_fields_for_type(const char *contact_path, const char *type, void (*callback)(GError *, GHashTable *, gpointer), gpointer data);
+/* like phoneui_utils_contact_get, returns a handle for phoneui_utils_cancel */
+int phoneui_utils_contact_get_cancellable(const char *contact_path, void (*callback)(GError *, GHashTable*, gpointer), gpointer data);
+/* returns a handle for phoneui_utils_cancel */
+int phoneui_utils_contact_get_fields_for_type(const char *contact_path, const char *type, void (*callback)(GError *, GHashTable *, gpointer), gpointer data);
 
 char *phoneui_utils_contact_display_phone_get(GHashTable *properties);
 char *phoneui_utils_contact_display_name_get(GHashTable *properties);
 int phoneui_utils_contact_compare(GHashTable *contact1, GHashTable *contact2);
 
+/* the fields a contact list row needs, taken from the properties once.
+ * Strings are owned by the record, NULL if the contact doesn't have the
+ * field - all other fields are in the properties table */
+struct PhoneuiContact *phoneui_utils_contact_record_new(GHashTable *properties);
+void phoneui_utils_contact_record_free(struct PhoneuiContact *contact);
+const char *phoneui_utils_contact_record_path(const struct PhoneuiContact *contact);
+const char *phoneui_utils_contact_record_name(const struct PhoneuiContact *contact);
+const char *phoneui_utils_contact_record_surname(const struct PhoneuiContact *contact);
+const char *phoneui_utils_contact_record_middlename(const struct PhoneuiContact *contact);
+const char *phoneui_utils_contact_record_nickname(const struct PhoneuiContact *contact);
+const char *phoneui_utils_contact_record_affiliation(const struct PhoneuiContact *contact);
+const char *phoneui_utils_contact_record_phone(const struct PhoneuiContact *contact);
+const char *phoneui_utils_contact_record_display_name(const struct PhoneuiContact *contact);
+GHashTable *phoneui_utils_contact_record_properties(const struct PhoneuiContact *contact);
+
 char *phoneui_utils_contact_get_dbus_path(int entryid);
 
 
@@ -31,11 +31,13 @@
 #include "phoneui-utils-dates.h"
 #include "dbus.h"
 #include "helpers.h"
+#include "cancel.h"
 
 #define FSO_FRAMEWORK_PIM_DatesServiceFace FSO_FRAMEWORK_PIM_ServiceFacePrefix ".Dates"
 #define FSO_FRAMEWORK_PIM_DatesServicePath FSO_FRAMEWORK_PIM_ServicePathPrefix "/Dates"
 
 struct _date_query_list_pack {
+	struct _cancellable *cancellable;
 	gpointer data;
 	void (*callback)(GError *, GHashTable **, int, gpointer);
 	FreeSmartphonePIMDateQuery *query;
@@ -141,12 +143,18 @@ _result_callback(GObject *source, GAsyncResult *res, gpointer data)
 
 	dates = free_smartphone_pim_date_query_get_multiple_results_finish
 					(pack->query, res, &count, &error);
-	pack->callback(error, dates, count, pack->data);
+	if (_cancellable_cancelled(pack->cancellable)) {
+		_cancel_results_drop(dates, count);
+	}
+	else {
+		pack->callback(error, dates, count, pack->data);
+	}
 	// FIXME: free messages !!!!
 	if (error) {
 		g_error_free(error);
 	}
 	g_object_unref(pack->query);
+	_cancellable_free(pack->cancellable);
 	free(pack);
 }
 
@@ -165,69 +173,85 @@ _query_dates_callback(GObject *source, GAsyncResult *res, gpointer data)
 	if (error) {
 		g_warning("message query error: (%d) %s",
 			  error->code, error->message);
-		pack->callback(error, NULL, 0, pack->data);
+		if (!_cancellable_cancelled(pack->cancellable))
+			pack->callback(error, NULL, 0, pack->data);
 		g_error_free(error);
+		_cancellable_free(pack->cancellable);
+		free(pack);
 		return;
 	}
 	pack->query = free_smartphone_pim_get_date_query_proxy(_dbus(),
 				FSO_FRAMEWORK_PIM_ServiceDBusName, query_path);
+	free(query_path);
+
+	if (_cancellable_cancelled(pack->cancellable)) {
+		/* don't transfer results nobody waits for */
+		free_smartphone_pim_date_query_dispose_(pack->query, NULL, NULL);
+		g_object_unref(pack->query);
+		_cancellable_free(pack->cancellable);
+		free(pack);
+		return;
+	}
 
 	free_smartphone_pim_date_query_get_multiple_results(pack->query, -1,
 							       _result_callback,
 							       pack);
 }
 
-void
+int
 phoneui_utils_dates_get_full(const char *sortby, gboolean sortdesc,
 			     time_t start_date, time_t end_date,
 			     void (*callback)(GError *, GHashTable **, int, gpointer),
 			     gpointer data)
 {
+	int handle;
 	struct _date_query_list_pack *pack;
 	GHashTable *query;
 	GValue *gval_tmp;
 
 	g_debug("Retrieving dates");
 
-	query = g_hash_table_new_full(g_str_hash, g_str_equal,
-						  NULL, _helpers_free_gvalue);
+	query = _helpers_new_field_table();
 
 	if (sortby && strlen(sortby)) {
 		gval_tmp = _helpers_new_gvalue_string(sortby);
-		g_hash_table_insert(query, "_sortby", gval_tmp);
+		g_hash_table_insert(query, _helpers_field("_sortby"), gval_tmp);
 	}
 
 	if (sortdesc) {
 		gval_tmp = _helpers_new_gvalue_boolean(sortdesc);
-		g_hash_table_insert(query, "_sortdesc", gval_tmp);
+		g_hash_table_insert(query, _helpers_field("_sortdesc"), gval_tmp);
 	}
 
 	if (start_date > 0) {
 		gval_tmp = _helpers_new_gvalue_int(start_date);
-		g_hash_table_insert(query, "_gt_Begin", gval_tmp);
+		g_hash_table_insert(query, _helpers_field("_gt_Begin"), gval_tmp);
 	}
 	
 	if (end_date > 0) {
 		gval_tmp = _helpers_new_gvalue_int(end_date);
-		g_hash_table_insert(query, "_lt_End", gval_tmp);
+		g_hash_table_insert(query, _helpers_field("_lt_End"), gval_tmp);
 	}
 
 	pack = malloc(sizeof(*pack));
+	pack->cancellable = _cancellable_new();
 	pack->callback = callback;
 	pack->data = data;
-	pack->dates = free_smartphone_pim_get_dates_proxy(_dbus(),
+	pack->dates = _DBUS_PROXY(free_smartphone_pim_get_dates_proxy,
 					FSO_FRAMEWORK_PIM_ServiceDBusName,
 					FSO_FRAMEWORK_PIM_DatesServicePath);
+	handle = (pack->cancellable) ? pack->cancellable->handle : 0;
 	g_debug("Firing the dates query");
 	free_smartphone_pim_dates_query(pack->dates, query,
 					   _query_dates_callback, pack);
 	g_hash_table_unref(query);
 	g_debug("Done");
+	return handle;
 }
 
-void
+int
 phoneui_utils_dates_get(void (*callback)(GError *, GHashTable **, int, gpointer),
 			   gpointer data)
 {
-	phoneui_utils_dates_get_full("Begin", TRUE, 0, 0, callback, data);
+	return phoneui_utils_dates_get_full("Begin", TRUE, 0, 0, callback, data);
 }
@@ -27,7 +27,7 @@
 
 int phoneui_utils_date_get(const char *path, void (*callback)(GError *, GHashTable *, gpointer), gpointer userdata);
 int phoneui_utils_day_get(const char *path, void (*callback)(GError *, GHashTable *, gpointer), gpointer userdata);
-void phoneui_utils_dates_get_full(const char *sortby, gboolean sortdesc, time_t start_date, time_t end_date, void (*callback)(GError *, GHashTable **, int, gpointer), gpointer data);
-void phoneui_utils_dates_get(void (*callback)(GError *, GHashTable **, int, gpointer), gpointer data);
+int phoneui_utils_dates_get_full(const char *sortby, gboolean sortdesc, time_t start_date, time_t end_date, void (*callback)(GError *, GHashTable **, int, gpointer), gpointer data);
+int phoneui_utils_dates_get(void (*callback)(GError *, GHashTable **, int, gpointer), gpointer data);
 
 #endif
@@ -31,6 +31,8 @@
 #include "phoneui-utils-messages.h"
 #include "dbus.h"
 #include "helpers.h"
+#include "messages-index.h"
+#include "cancel.h"
 
 struct _message_pack {
 	FreeSmartphonePIMMessage *message;
@@ -46,10 +48,30 @@ struct _message_add_pack {
 
 struct _message_get_pack {
 	FreeSmartphonePIMMessage *message;
+	struct _cancellable *cancellable;
 	void (*callback)(GError *, GHashTable *, gpointer);
 	gpointer data;
 };
 
+/* how many updates of a batch are on the bus at the same time */
+#define MESSAGE_BATCH_WINDOW 8
+
+struct _message_batch {
+	char **paths;
+	int next;
+	int running;
+	int failed;
+	GError *error;
+	GHashTable *update;	/* NULL for deleting */
+	void (*callback)(GError *, int, gpointer);
+	gpointer data;
+};
+
+struct _message_batch_item {
+	struct _message_batch *batch;
+	FreeSmartphonePIMMessage *message;
+};
+
 struct _message_query_list_pack {
 	gpointer data;
 	void (*callback)(GError *, GHashTable **, int, gpointer);
@@ -65,38 +87,37 @@ _message_hashtable_get(const char *direction, long timestamp,
 	GHashTable *message;
 	GValue *gval_tmp;
 
-	message = g_hash_table_new_full(g_str_hash, g_str_equal,
-						  NULL, _helpers_free_gvalue);
+	message = _helpers_new_field_table();
 
 	if (!message)
 		return NULL;
 
 	if (direction && (!strcmp(direction, "in") || !strcmp(direction, "out"))) {
 		gval_tmp = _helpers_new_gvalue_string(direction);
-		g_hash_table_insert(message, "Direction", gval_tmp);
+		g_hash_table_insert(message, _helpers_field("Direction"), gval_tmp);
 	}
 
 	if (timestamp > 0) {
 		gval_tmp = _helpers_new_gvalue_int(timestamp);
-		g_hash_table_insert(message, "Timestamp", gval_tmp);
+		g_hash_table_insert(message, _helpers_field("Timestamp"), gval_tmp);
 	}
 
 	if (content) {
 		gval_tmp = _helpers_new_gvalue_string(content);
-		g_hash_table_insert(message, "Content", gval_tmp);
+		g_hash_table_insert(message, _helpers_field("Content"), gval_tmp);
 	}
 
 	if (source) {
 		gval_tmp = _helpers_new_gvalue_string(source);
-		g_hash_table_insert(message, "Source", gval_tmp);
+		g_hash_table_insert(message, _helpers_field("Source"), gval_tmp);
 	}
 
 	gval_tmp = _helpers_new_gvalue_boolean(is_new);
-	g_hash_table_insert(message, "New", gval_tmp);
+	g_hash_table_insert(message, _helpers_field("New"), gval_tmp);
 
 	if (peer) {
 		gval_tmp = _helpers_new_gvalue_string(peer);
-		g_hash_table_insert(message, "Peer", gval_tmp);
+		g_hash_table_insert(message, _helpers_field("Peer"), gval_tmp);
 	}
 
 	return message;
@@ -131,7 +152,7 @@ phoneui_utils_message_add(GHashTable *message,
 	pack = malloc(sizeof(*pack));
 	pack->callback = callback;
 	pack->data = data;
-	pack->messages = free_smartphone_pim_get_messages_proxy(_dbus(),
+	pack->messages = _DBUS_PROXY(free_smartphone_pim_get_messages_proxy,
 					FSO_FRAMEWORK_PIM_ServiceDBusName,
 					FSO_FRAMEWORK_PIM_MessagesServicePath);
 
@@ -287,6 +308,151 @@ phoneui_utils_message_set_sent_status(const char *path, int sent,
 	return phoneui_utils_message_set_new_status(path, !sent, callback, data);
 }
 
+static void _message_batch_fill(struct _message_batch *batch);
+
+static void
+_message_batch_callback(GObject *source, GAsyncResult *res, gpointer data)
+{
+	(void) source;
+	GError *error = NULL;
+	struct _message_batch_item *item = data;
+	struct _message_batch *batch = item->batch;
+
+	if (batch->update) {
+		free_smartphone_pim_message_update_finish(item->message, res,
+							  &error);
+	}
+	else {
+		free_smartphone_pim_message_delete_finish(item->message, res,
+							  &error);
+	}
+	if (error) {
+		g_warning("Batch operation on a message failed: (%d) %s",
+			  error->code, error->message);
+		batch->failed++;
+		/* only the first error gets reported */
+		if (batch->error) {
+			g_error_free(error);
+		}
+		else {
+			batch->error = error;
+		}
+	}
+	g_object_unref(item->message);
+	free(item);
+
+	batch->running--;
+	_message_batch_fill(batch);
+}
+
+static void
+_message_batch_fill(struct _message_batch *batch)
+{
+	struct _message_batch_item *item;
+
+	while (batch->running < MESSAGE_BATCH_WINDOW &&
+			batch->paths[batch->next]) {
+		item = malloc(sizeof(*item));
+		item->batch = batch;
+		item->message = free_smartphone_pim_get_message__proxy(_dbus(),
+				FSO_FRAMEWORK_PIM_ServiceDBusName,
+				batch->paths[batch->next]);
+		batch->next++;
+		batch->running++;
+		if (batch->update) {
+			free_smartphone_pim_message_update(item->message,
+					batch->update, _message_batch_callback, item);
+		}
+		else {
+			free_smartphone_pim_message_delete(item->message,
+					_message_batch_callback, item);
+		}
+	}
+	if (batch->running > 0)
+		return;
+
+	g_debug("Message batch done: %d messages, %d failed",
+		batch->next, batch->failed);
+	if (batch->callback) {
+		batch->callback(batch->error, batch->failed, batch->data);
+	}
+	if (batch->error) {
+		g_error_free(batch->error);
+	}
+	if (batch->update) {
+		g_hash_table_unref(batch->update);
+	}
+	g_strfreev(batch->paths);
+	free(batch);
+}
+
+static int
+_message_batch_start(const char **paths, GHashTable *update,
+		     void (*callback)(GError *, int, gpointer), gpointer data)
+{
+	struct _message_batch *batch;
+
+	if (!paths)
+		return 1;
+
+	batch = malloc(sizeof(*batch));
+	if (!batch)
+		return 1;
+	batch->paths = g_strdupv((char **) paths);
+	batch->next = 0;
+	batch->running = 0;
+	batch->failed = 0;
+	batch->error = NULL;
+	batch->update = update;
+	batch->callback = callback;
+	batch->data = data;
+
+	_message_batch_fill(batch);
+	return 0;
+}
+
+int
+phoneui_utils_messages_set_new_status(const char **paths, gboolean new,
+				void (*callback) (GError *, int, gpointer),
+				gpointer data)
+{
+	GHashTable *update;
+
+	if (!paths)
+		return 1;
+
+	/* all messages get the very same update */
+	update = _helpers_new_field_table();
+	g_hash_table_insert(update, _helpers_field("New"),
+			    _helpers_new_gvalue_boolean(new));
+
+	return _message_batch_start(paths, update, callback, data);
+}
+
+int
+phoneui_utils_messages_set_read_status(const char **paths, int read,
+				void (*callback) (GError *, int, gpointer),
+				gpointer data)
+{
+	return phoneui_utils_messages_set_new_status(paths, !read, callback, data);
+}
+
+int
+phoneui_utils_messages_set_sent_status(const char **paths, int sent,
+				void (*callback) (GError *, int, gpointer),
+				gpointer data)
+{
+	return phoneui_utils_messages_set_new_status(paths, !sent, callback, data);
+}
+
+int
+phoneui_utils_messages_delete(const char **paths,
+			      void (*callback) (GError *, int, gpointer),
+			      gpointer data)
+{
+	return _message_batch_start(paths, NULL, callback, data);
+}
+
 static void
 _message_get_callback(GObject *source, GAsyncResult *res, gpointer data)
 {
@@ -296,7 +462,7 @@ _message_get_callback(GObject *source, GAsyncResult *res, gpointer data)
 	struct _message_get_pack *pack = data;
 	message_data = free_smartphone_pim_message_get_content_finish
 						(pack->message, res, &error);
-	if (pack->callback) {
+	if (pack->callback && !_cancellable_cancelled(pack->cancellable)) {
 		pack->callback(error, message_data, pack->data);
 	}
 	if (error) {
@@ -308,21 +474,25 @@ _message_get_callback(GObject *source, GAsyncResult *res, gpointer data)
 		g_hash_table_unref(message_data);
 	}
 end:
+	_cancellable_free(pack->cancellable);
 	g_object_unref(pack->message);
 	free(pack);
 }
 
-int
-phoneui_utils_message_get(const char *message_path,
-			  void (*callback)(GError *, GHashTable *, gpointer),
-			  gpointer data)
+static struct _message_get_pack *
+_message_get(const char *message_path, gboolean cancellable,
+	     void (*callback)(GError *, GHashTable *, gpointer), gpointer data)
 {
 	struct _message_get_pack *pack;
 
-	if (!message_path)
-		return 1;
-
 	pack = malloc(sizeof(*pack));
+	if (!pack)
+		return NULL;
+	pack->cancellable = NULL;
+	if (cancellable && !(pack->cancellable = _cancellable_new())) {
+		free(pack);
+		return NULL;
+	}
 	pack->data = data;
 	pack->callback = callback;
 	pack->message = free_smartphone_pim_get_message__proxy(_dbus(),
@@ -330,22 +500,48 @@ phoneui_utils_message_get(const char *message_path,
 	g_debug("Getting data of message with path: %s", message_path);
 	free_smartphone_pim_message_get_content(pack->message,
 						_message_get_callback, pack);
+	return pack;
+}
+
+int
+phoneui_utils_message_get(const char *message_path,
+			  void (*callback)(GError *, GHashTable *, gpointer),
+			  gpointer data)
+{
+	if (!message_path)
+		return 1;
+
+	_message_get(message_path, FALSE, callback, data);
 	return (0);
 }
 
-void
+int
+phoneui_utils_message_get_cancellable(const char *message_path,
+			  void (*callback)(GError *, GHashTable *, gpointer),
+			  gpointer data)
+{
+	struct _message_get_pack *pack;
+
+	if (!message_path)
+		return 0;
+
+	pack = _message_get(message_path, TRUE, callback, data);
+	return (pack) ? pack->cancellable->handle : 0;
+}
+
+int
 phoneui_utils_messages_query(const char *sortby, gboolean sortdesc,
 			   gboolean disjunction, int limit_start, int limit,
 			   gboolean resolve_number, const GHashTable *options,
 			   void (*callback)(GError *, GHashTable **, int, gpointer),
 			   gpointer data)
 {
-	phoneui_utils_pim_query(PHONEUI_PIM_DOMAIN_MESSAGES, sortby, sortdesc,
+	return phoneui_utils_pim_query(PHONEUI_PIM_DOMAIN_MESSAGES, sortby, sortdesc,
 				disjunction, limit_start, limit, resolve_number, options,
 				callback, data);
 }
 
-void
+int
 phoneui_utils_messages_query_full(const char *sortby, gboolean sortdesc,
 			   gboolean disjunction, int limit_start, int limit,
 			   gboolean resolve_number,
@@ -354,42 +550,52 @@ phoneui_utils_messages_query_full(const char *sortby, gboolean sortdesc,
 			   void (*callback)(GError *, GHashTable **, int, gpointer),
 			   gpointer data)
 {
+	int handle;
 	GHashTable *query;
 	query = _message_hashtable_get(direction, timestamp, content, source,
 				     is_new, peer);
 
-	phoneui_utils_messages_query(sortby, sortdesc, disjunction, limit_start,
-				   limit, resolve_number, query, callback, data);
+	handle = phoneui_utils_messages_query(sortby, sortdesc, disjunction,
+			limit_start, limit, resolve_number, query, callback, data);
 	g_hash_table_unref(query);
+	return handle;
 }
 
-void
+int
 phoneui_utils_messages_get_full(const char *sortby, gboolean sortdesc, int limit_start,
 			   int limit, gboolean resolve_number, const char *direction,
 			   void (*callback)(GError *, GHashTable **, int, gpointer), gpointer data)
 {
+	int handle;
 	GHashTable *query;
 	GValue *gval_tmp;
 
 	g_debug("Retrieving messages");
 
-	query = g_hash_table_new_full(g_str_hash, g_str_equal,
-						  NULL, _helpers_free_gvalue);
+	query = _helpers_new_field_table();
 
 	if (direction && (!strcmp(direction, "in") || !strcmp(direction, "out"))) {
 		gval_tmp = _helpers_new_gvalue_string(direction);
-		g_hash_table_insert(query, "Direction", gval_tmp);
+		g_hash_table_insert(query, _helpers_field("Direction"), gval_tmp);
 	}
 
-	phoneui_utils_messages_query(sortby, sortdesc, FALSE, limit_start, limit,
-				resolve_number, query, callback, data);
+	handle = phoneui_utils_messages_query(sortby, sortdesc, FALSE,
+			limit_start, limit, resolve_number, query, callback, data);
 
 	g_hash_table_unref(query);
+	return handle;
 }
 
-void
+int
 phoneui_utils_messages_get(void (*callback)(GError *, GHashTable **, int, gpointer),
 			   gpointer data)
 {
-	phoneui_utils_messages_get_full("Timestamp", TRUE, 0, -1, TRUE, NULL, callback, data);
+	return phoneui_utils_messages_get_full("Timestamp", TRUE, 0, -1, TRUE, NULL, callback, data);
+}
+
+int
+phoneui_utils_message_threads_get(void (*callback)(GError *, GHashTable **, int, gpointer),
+				  gpointer data)
+{
+	return _messages_index_threads_get(callback, data);
 }
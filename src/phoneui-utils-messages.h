@@ -34,11 +34,26 @@ int phoneui_utils_message_set_new_status(const char *path, gboolean is_new, void
 int phoneui_utils_message_set_read_status(const char *path, int read, void (*callback) (GError *, gpointer), gpointer data);
 int phoneui_utils_message_set_sent_status(const char *path, int sent, void (*callback) (GError *, gpointer), gpointer data);
 int phoneui_utils_message_get(const char *message_path, void (*callback)(GError *, GHashTable *, gpointer), gpointer data);
+/* like phoneui_utils_message_get, returns a handle for phoneui_utils_cancel */
+int phoneui_utils_message_get_cancellable(const char *message_path, void (*callback)(GError *, GHashTable *, gpointer), gpointer data);
 
-void phoneui_utils_messages_query(const char *sortby, gboolean sortdesc, gboolean disjunction, int limit_start, int limit, gboolean resolve_number, const GHashTable *options, void (*callback)(GError *, GHashTable **, int, gpointer), gpointer data);
-void phoneui_utils_messages_query_full(const char *sortby, gboolean sortdesc, gboolean disjunction, int limit_start, int limit, gboolean resolve_number, const char *direction, long timestamp, const char *content, const char *source, gboolean is_new, const char *peer, void (*callback)(GError *, GHashTable **, int, gpointer), gpointer data);
+/* Batch variants for a NULL terminated list of message paths. The callback
+ * is called once when all are done, with the first error and the number of
+ * messages that failed. */
+int phoneui_utils_messages_set_new_status(const char **paths, gboolean is_new, void (*callback) (GError *, int failed, gpointer), gpointer data);
+int phoneui_utils_messages_set_read_status(const char **paths, int read, void (*callback) (GError *, int failed, gpointer), gpointer data);
+int phoneui_utils_messages_set_sent_status(const char **paths, int sent, void (*callback) (GError *, int failed, gpointer), gpointer data);
+int phoneui_utils_messages_delete(const char **paths, void (*callback) (GError *, int failed, gpointer), gpointer data);
 
-void phoneui_utils_messages_get_full(const char *sortby, gboolean sortdesc, int limit_start, int limit, gboolean resolve_number, const char *direction, void (*callback)(GError *, GHashTable **, int, gpointer), gpointer data);
-void phoneui_utils_messages_get(void (*callback) (GError *, GHashTable **, int, void *), gpointer data);
+int phoneui_utils_messages_query(const char *sortby, gboolean sortdesc, gboolean disjunction, int limit_start, int limit, gboolean resolve_number, const GHashTable *options, void (*callback)(GError *, GHashTable **, int, gpointer), gpointer data);
+int phoneui_utils_messages_query_full(const char *sortby, gboolean sortdesc, gboolean disjunction, int limit_start, int limit, gboolean resolve_number, const char *direction, long timestamp, const char *content, const char *source, gboolean is_new, const char *peer, void (*callback)(GError *, GHashTable **, int, gpointer), gpointer data);
+
+int phoneui_utils_messages_get_full(const char *sortby, gboolean sortdesc, int limit_start, int limit, gboolean resolve_number, const char *direction, void (*callback)(GError *, GHashTable **, int, gpointer), gpointer data);
+int phoneui_utils_messages_get(void (*callback) (GError *, GHashTable **, int, void *), gpointer data);
+
+/* One table per conversation, newest first: Peer, Count, Unread (new
+ * incoming messages), Timestamp and Path, Content and Direction of the
+ * last message. Served from an index that is built on the first call */
+int phoneui_utils_message_threads_get(void (*callback)(GError *, GHashTable **, int, gpointer), gpointer data);
 
 #endif
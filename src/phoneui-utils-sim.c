@@ -89,7 +89,7 @@ phoneui_utils_sim_contact_delete(const char *category, const int index,
 	pack = malloc(sizeof(*pack));
 	pack->callback = callback;
 	pack->data = data;
-	pack->sim = free_smartphone_gsm_get_s_i_m_proxy(_dbus(),
+	pack->sim = _DBUS_PROXY(free_smartphone_gsm_get_s_i_m_proxy,
 					FSO_FRAMEWORK_GSM_ServiceDBusName,
 					FSO_FRAMEWORK_GSM_DeviceServicePath);
 	free_smartphone_gsm_sim_delete_entry(pack->sim, category, index,
@@ -129,7 +129,7 @@ phoneui_utils_sim_contact_store(const char *category, const int index,
 	pack = malloc(sizeof(*pack));
 	pack->callback = callback;
 	pack->data = data;
-	pack->sim = free_smartphone_gsm_get_s_i_m_proxy(_dbus(),
+	pack->sim = _DBUS_PROXY(free_smartphone_gsm_get_s_i_m_proxy,
 					FSO_FRAMEWORK_GSM_ServiceDBusName,
 					FSO_FRAMEWORK_GSM_DeviceServicePath);
 	free_smartphone_gsm_sim_store_entry(pack->sim, category, index,
@@ -172,7 +172,7 @@ phoneui_utils_sim_contacts_get(const char *category,
 	pack = malloc(sizeof(*pack));
 	pack->callback = callback;
 	pack->data = data;
-	pack->sim = free_smartphone_gsm_get_s_i_m_proxy(_dbus(),
+	pack->sim = _DBUS_PROXY(free_smartphone_gsm_get_s_i_m_proxy,
 					FSO_FRAMEWORK_GSM_ServiceDBusName,
 					FSO_FRAMEWORK_GSM_DeviceServicePath);
 
@@ -217,7 +217,7 @@ phoneui_utils_sim_phonebook_info_get(const char *category,
 	pack = malloc(sizeof(*pack));
 	pack->callback = callback;
 	pack->data = data;
-	pack->sim = free_smartphone_gsm_get_s_i_m_proxy(_dbus(),
+	pack->sim = _DBUS_PROXY(free_smartphone_gsm_get_s_i_m_proxy,
 					FSO_FRAMEWORK_GSM_ServiceDBusName,
 					FSO_FRAMEWORK_GSM_DeviceServicePath);
 	free_smartphone_gsm_sim_get_phonebook_info(pack->sim, category,
@@ -261,7 +261,7 @@ phoneui_utils_sim_phonebook_entry_get(const char *category, const int index,
 	pack = malloc(sizeof(*pack));
 	pack->callback = callback;
 	pack->data = data;
-	pack->sim = free_smartphone_gsm_get_s_i_m_proxy(_dbus(),
+	pack->sim = _DBUS_PROXY(free_smartphone_gsm_get_s_i_m_proxy,
 					FSO_FRAMEWORK_GSM_ServiceDBusName,
 					FSO_FRAMEWORK_GSM_DeviceServicePath);
 	free_smartphone_gsm_sim_retrieve_phonebook(pack->sim, category, index,
@@ -299,7 +299,7 @@ phoneui_utils_sim_pin_send(const char *pin,
 	pack = malloc(sizeof(*pack));
 	pack->data = data;
 	pack->callback = callback;
-	pack->sim = free_smartphone_gsm_get_s_i_m_proxy(_dbus(),
+	pack->sim = _DBUS_PROXY(free_smartphone_gsm_get_s_i_m_proxy,
 					FSO_FRAMEWORK_GSM_ServiceDBusName,
 					FSO_FRAMEWORK_GSM_DeviceServicePath);
 	free_smartphone_gsm_sim_send_auth_code
@@ -337,7 +337,7 @@ phoneui_utils_sim_puk_send(const char *puk, const char *new_pin,
 	pack = malloc(sizeof(*pack));
 	pack->data = data;
 	pack->callback = callback;
-	pack->sim = free_smartphone_gsm_get_s_i_m_proxy(_dbus(),
+	pack->sim = _DBUS_PROXY(free_smartphone_gsm_get_s_i_m_proxy,
 					FSO_FRAMEWORK_GSM_ServiceDBusName,
 					FSO_FRAMEWORK_GSM_DeviceServicePath);
 	free_smartphone_gsm_sim_unlock
@@ -376,7 +376,7 @@ phoneui_utils_sim_auth_status_get(void (*callback)(GError *,
 	pack = malloc(sizeof(*pack));
 	pack->data = data;
 	pack->callback = callback;
-	pack->sim = free_smartphone_gsm_get_s_i_m_proxy(_dbus(),
+	pack->sim = _DBUS_PROXY(free_smartphone_gsm_get_s_i_m_proxy,
 					FSO_FRAMEWORK_GSM_ServiceDBusName,
 					FSO_FRAMEWORK_GSM_DeviceServicePath);
 	free_smartphone_gsm_sim_get_auth_status
@@ -816,6 +816,7 @@ _list_profiles_callback(GObject *source, GAsyncResult *res, gpointer data)
 		pack->callback(error, profiles, count, pack->data);
 	}
 	// FIXME: free profiles
+	g_object_unref(pack->preferences);
 	free(pack);
 }
 
@@ -828,7 +829,7 @@ phoneui_utils_sound_profile_list(void (*callback)(GError *, char **, int, gpoint
 	pack = malloc(sizeof(*pack));
 	pack->callback = callback;
 	pack->data = userdata;
-	pack->preferences = free_smartphone_get_preferences_proxy(_dbus(),
+	pack->preferences = _DBUS_PROXY(free_smartphone_get_preferences_proxy,
 				FSO_FRAMEWORK_PREFERENCES_ServiceDBusName,
 				FSO_FRAMEWORK_PREFERENCES_ServicePathPrefix);
 	free_smartphone_preferences_get_profiles
@@ -878,7 +879,7 @@ phoneui_utils_sound_profile_set(const char *profile,
 	pack = malloc(sizeof(*pack));
 	pack->callback = callback;
 	pack->data = userdata;
-	pack->preferences = free_smartphone_get_preferences_proxy(_dbus(),
+	pack->preferences = _DBUS_PROXY(free_smartphone_get_preferences_proxy,
 				FSO_FRAMEWORK_PREFERENCES_ServiceDBusName,
 				FSO_FRAMEWORK_PREFERENCES_ServicePathPrefix);
 
@@ -905,6 +906,7 @@ _get_profile_callback(GObject *source, GAsyncResult *res, gpointer data)
 	if (pack->callback) {
 		pack->callback(error, profile, pack->data);
 	}
+	g_object_unref(pack->preferences);
 	free(pack);
 }
 
@@ -917,7 +919,7 @@ phoneui_utils_sound_profile_get(void (*callback)(GError *, char *, gpointer),
 	pack = malloc(sizeof(*pack));
 	pack->callback = callback;
 	pack->data = userdata;
-	pack->preferences = free_smartphone_get_preferences_proxy(_dbus(),
+	pack->preferences = _DBUS_PROXY(free_smartphone_get_preferences_proxy,
 				FSO_FRAMEWORK_PREFERENCES_ServiceDBusName,
 				FSO_FRAMEWORK_PREFERENCES_ServicePathPrefix);
 	free_smartphone_preferences_get_profile(pack->preferences,
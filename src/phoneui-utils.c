@@ -40,13 +40,20 @@
 #include "phoneui-utils-contacts.h"
 #include "phoneui-utils-messages.h"
 #include "dbus.h"
+#include "contacts-index.h"
+#include "messages-index.h"
+#include "startup-timing.h"
+#include "latency.h"
+#include "query-cache.h"
+#include "outbox.h"
+#include "cancel.h"
 #include "helpers.h"
 
-#define PIM_DOMAIN_PROXY(func) (void *(*)(DBusGConnection*, const char*, const char*)) func
 #define PIM_QUERY_FUNCTION(func) (void (*)(void *, GHashTable *, GAsyncReadyCallback, gpointer)) func
 #define PIM_QUERY_RESULTS(func) (void (*)(void *, int, GAsyncReadyCallback, gpointer)) func
 #define PIM_QUERY_RESULTS_FINISH(func) (GHashTable** (*)(void*, GAsyncResult*, int*, GError**)) func
 #define PIM_QUERY_COUNT(func) (void (*)(void *, GAsyncReadyCallback, gpointer)) func
+#define PIM_QUERY_COUNT_FINISH(func) (int (*)(void *, GAsyncResult*, GError**)) func
 #define PIM_QUERY_PROXY(func) (void *(*)(DBusGConnection*, const char*, const char*)) func
 #define PIM_QUERY_DISPOSE(func) (void (*)(void *query, GAsyncReadyCallback, gpointer)) func
 
@@ -68,26 +75,105 @@ struct _idle_pack {
 	gpointer data;
 };
 
-struct _sms_send_pack {
+struct _sms_send_batch {
 	FreeSmartphoneGSMSMS *sms;
 	FreeSmartphonePIMMessages *pim_messages;
+	GPtrArray *packs;	/* in recipient order */
+	guint next;		/* next one to start */
+	guint reported;		/* next one to report */
+	int running;
+	int sent;
+	int failed;
+	void (*progress)(GError *, int, int, const char *, gpointer);
+	void (*summary)(int, int, gpointer);
+	gpointer data;
+};
+
+struct _sms_send_pack {
+	struct _sms_send_batch *batch;
+	int index;
+	int outbox_id;
+	int attempts;
 	char *number;
-	const char *message;
+	char *message;
 	char *pim_path;
+	gboolean storing;	/* opimd add still running */
+	gboolean sent;		/* GSM send finished, successfully or not */
+	gboolean done;
+	GError *error;
+	int reference;
+	char *timestamp;
+};
+
+struct _sms_send_legacy_pack {
 	void (*callback)(GError *, int, const char *, gpointer);
 	gpointer data;
 };
 
+/* how many recipients are being saved/sent at the same time */
+static int sms_window = 4;
+/* how often a failed send is retried, with doubling delays. Off by
+ * default, failures get reported right away */
+static int sms_retries = 0;
+/* how often a failed SMS is sent again from the outbox, the delays
+ * start at SMS_REPLAY_DELAY seconds and double each round */
+#define SMS_REPLAY_DELAY 30
+static int sms_replays = 5;
+static int sms_replay_round = 0;
+static guint sms_replay_source = 0;
+/* store in opimd while sending instead of before */
+static gboolean sms_store_concurrent = FALSE;
+
+static gboolean _sms_outbox_replay(gpointer data);
+
+struct _pim_query_funcs {
+	void *(*query_proxy)(DBusGConnection *, const char *, const char *);
+	void (*count)(void *query, GAsyncReadyCallback, gpointer);
+	int (*count_finish)(void *query, GAsyncResult *, GError **);
+	void (*results)(void *query, int count, GAsyncReadyCallback, gpointer);
+	GHashTable **(*results_finish)(void *query, GAsyncResult *, int *count, GError **);
+	void (*dispose)(void *query, GAsyncReadyCallback, gpointer);
+};
+
+struct PhoneuiPimCursor {
+	void *query;
+	struct _pim_query_funcs funcs;
+	int chunk_size;
+	gboolean fetching;
+	gboolean closed;
+	void (*opened)(GError *, struct PhoneuiPimCursor *, int, gpointer);
+	void (*callback)(GError *, GHashTable **, int, gpointer);
+	gpointer data;
+};
+
 struct _query_pack {
 	enum PhoneUiPimDomain domain_type;
 	void *query;
 	void *domain;
+	struct PhoneuiPimCursor *cursor;
+	gdouble started;
+	char *key;
+	gboolean cached;
+	guint cache_generation;
+	/* callers of the same query that came in while it was running */
+	GSList *waiters;
+	struct _cancellable *cancellable;
 	void (*callback)(GError *, GHashTable **, int, gpointer);
 	gpointer data;
 };
 
+struct _query_waiter {
+	struct _cancellable *cancellable;
+	void (*callback)(GError *, GHashTable **, int, gpointer);
+	gpointer data;
+};
+
+/* running queries by key - identical ones just wait for their results */
+static GHashTable *queries_in_flight = NULL;
+
 struct _call_get_pack {
 	FreeSmartphonePIMCall *call;
+	struct _cancellable *cancellable;
 	void (*callback)(GError *, GHashTable *, gpointer);
 	gpointer data;
 };
@@ -122,14 +208,47 @@ struct _set_pin_pack {
 int
 phoneui_utils_init(GKeyFile *keyfile)
 {
-	int ret;
+	int ret, window;
+	char *store;
+	gdouble start;
+
+	start = _startup_timing_begin();
 	ret = phoneui_utils_sound_init(keyfile);
+	_startup_timing_end(start, "utils sound init");
+	start = _startup_timing_begin();
 	ret = phoneui_utils_device_init(keyfile);
+	_startup_timing_end(start, "utils device init");
+	start = _startup_timing_begin();
 	ret = phoneui_utils_feedback_init(keyfile);
+	_startup_timing_end(start, "utils feedback init");
+	_query_cache_load_config(keyfile);
+	window = g_key_file_get_integer(keyfile, "sms", "window", NULL);
+	if (window > 0) {
+		sms_window = window;
+	}
+	if (g_key_file_has_key(keyfile, "sms", "retries", NULL)) {
+		sms_retries = g_key_file_get_integer(keyfile, "sms", "retries",
+						     NULL);
+	}
+	if (g_key_file_has_key(keyfile, "sms", "replays", NULL)) {
+		sms_replays = g_key_file_get_integer(keyfile, "sms", "replays",
+						     NULL);
+	}
+	store = g_key_file_get_string(keyfile, "sms", "store", NULL);
+	if (store) {
+		sms_store_concurrent = !strcmp(store, "concurrent");
+		g_free(store);
+	}
+	_outbox_load_config(keyfile);
+	if (_outbox_pending_count()) {
+		sms_replay_source = g_idle_add(_sms_outbox_replay, NULL);
+	}
 
 	// FIXME: remove when vala learned to handle multi-field contacts !!!
 	g_debug("Initing libframeworkd-glib :(");
+	start = _startup_timing_begin();
 	frameworkd_handler_connect(NULL);
+	_startup_timing_end(start, "utils frameworkd connect");
 
 	return 0;
 }
@@ -139,93 +258,221 @@ phoneui_utils_deinit()
 {
 	/*FIXME: stub*/
 	phoneui_utils_sound_deinit();
+	_contacts_index_deinit();
+	_messages_index_deinit();
+	_dbus_proxies_clear();
+	_query_cache_deinit();
+	if (sms_replay_source) {
+		g_source_remove(sms_replay_source);
+		sms_replay_source = 0;
+	}
+	sms_replay_round = 0;
+	_outbox_deinit();
+	if (queries_in_flight) {
+		/* the running queries still free their packs */
+		g_hash_table_destroy(queries_in_flight);
+		queries_in_flight = NULL;
+	}
+	_helpers_gvalue_pool_clear();
 }
 
-static void
-_pim_query_results_callback(GObject *source, GAsyncResult *res, gpointer data)
+static gboolean
+_pim_query_funcs_get(enum PhoneUiPimDomain domain, struct _pim_query_funcs *funcs)
 {
-	(void) source;
-	int count;
-	GHashTable **results;
-	GError *error = NULL;
-	struct _query_pack *pack = data;
-	void (*dispose_func)(void *query, GAsyncReadyCallback, gpointer);
-	GHashTable** (*results_func)(void *query, GAsyncResult*, int* count, GError**);
-
-	dispose_func = NULL;
-	results_func = NULL;
-
-	switch(pack->domain_type) {
+	switch(domain) {
 		case PHONEUI_PIM_DOMAIN_CALLS:
-			dispose_func = PIM_QUERY_DISPOSE(free_smartphone_pim_call_query_dispose_);
-			results_func = PIM_QUERY_RESULTS_FINISH(
-					free_smartphone_pim_call_query_get_multiple_results_finish);
+			funcs->query_proxy = PIM_QUERY_PROXY(free_smartphone_pim_get_call_query_proxy);
+			funcs->count = PIM_QUERY_COUNT(free_smartphone_pim_call_query_get_result_count);
+			funcs->count_finish = PIM_QUERY_COUNT_FINISH
+				(free_smartphone_pim_call_query_get_result_count_finish);
+			funcs->results = PIM_QUERY_RESULTS
+				(free_smartphone_pim_call_query_get_multiple_results);
+			funcs->results_finish = PIM_QUERY_RESULTS_FINISH
+				(free_smartphone_pim_call_query_get_multiple_results_finish);
+			funcs->dispose = PIM_QUERY_DISPOSE(free_smartphone_pim_call_query_dispose_);
 			break;
 		case PHONEUI_PIM_DOMAIN_CONTACTS:
-			dispose_func = PIM_QUERY_DISPOSE(free_smartphone_pim_contact_query_dispose_);
-			results_func = PIM_QUERY_RESULTS_FINISH(
-				free_smartphone_pim_contact_query_get_multiple_results_finish);
+			funcs->query_proxy = PIM_QUERY_PROXY(free_smartphone_pim_get_contact_query_proxy);
+			funcs->count = PIM_QUERY_COUNT(free_smartphone_pim_contact_query_get_result_count);
+			funcs->count_finish = PIM_QUERY_COUNT_FINISH
+				(free_smartphone_pim_contact_query_get_result_count_finish);
+			funcs->results = PIM_QUERY_RESULTS
+				(free_smartphone_pim_contact_query_get_multiple_results);
+			funcs->results_finish = PIM_QUERY_RESULTS_FINISH
+				(free_smartphone_pim_contact_query_get_multiple_results_finish);
+			funcs->dispose = PIM_QUERY_DISPOSE(free_smartphone_pim_contact_query_dispose_);
 			break;
 /* FIXME, re-enable it when libfsoframework supports it again
 		case PHONEUI_PIM_DOMAIN_DATES:
-			dispose_func = PIM_QUERY_DISPOSE(free_smartphone_pim_date_query_dispose_);
-			results_func = PIM_QUERY_RESULTS_FINISH(
-				free_smartphone_pim_date_query_get_multiple_results_finish);
+			funcs->query_proxy = PIM_QUERY_PROXY(free_smartphone_pim_get_date_query_proxy);
+			funcs->count = PIM_QUERY_COUNT(free_smartphone_pim_date_query_get_result_count);
+			funcs->count_finish = PIM_QUERY_COUNT_FINISH
+				(free_smartphone_pim_date_query_get_result_count_finish);
+			funcs->results = PIM_QUERY_RESULTS
+				(free_smartphone_pim_date_query_get_multiple_results);
+			funcs->results_finish = PIM_QUERY_RESULTS_FINISH
+				(free_smartphone_pim_date_query_get_multiple_results_finish);
+			funcs->dispose = PIM_QUERY_DISPOSE(free_smartphone_pim_date_query_dispose_);
 			break;
 */
 		case PHONEUI_PIM_DOMAIN_MESSAGES:
-			dispose_func = PIM_QUERY_DISPOSE(free_smartphone_pim_message_query_dispose_);
-			results_func = PIM_QUERY_RESULTS_FINISH(
-				free_smartphone_pim_message_query_get_multiple_results_finish);
+			funcs->query_proxy = PIM_QUERY_PROXY(free_smartphone_pim_get_message_query_proxy);
+			funcs->count = PIM_QUERY_COUNT(free_smartphone_pim_message_query_get_result_count);
+			funcs->count_finish = PIM_QUERY_COUNT_FINISH
+				(free_smartphone_pim_message_query_get_result_count_finish);
+			funcs->results = PIM_QUERY_RESULTS
+				(free_smartphone_pim_message_query_get_multiple_results);
+			funcs->results_finish = PIM_QUERY_RESULTS_FINISH
+				(free_smartphone_pim_message_query_get_multiple_results_finish);
+			funcs->dispose = PIM_QUERY_DISPOSE(free_smartphone_pim_message_query_dispose_);
 			break;
 		case PHONEUI_PIM_DOMAIN_NOTES:
-			dispose_func = PIM_QUERY_DISPOSE(free_smartphone_pim_note_query_dispose_);
-			results_func = PIM_QUERY_RESULTS_FINISH(
-				free_smartphone_pim_note_query_get_multiple_results_finish);
+			funcs->query_proxy = PIM_QUERY_PROXY(free_smartphone_pim_get_note_query_proxy);
+			funcs->count = PIM_QUERY_COUNT(free_smartphone_pim_note_query_get_result_count);
+			funcs->count_finish = PIM_QUERY_COUNT_FINISH
+				(free_smartphone_pim_note_query_get_result_count_finish);
+			funcs->results = PIM_QUERY_RESULTS
+				(free_smartphone_pim_note_query_get_multiple_results);
+			funcs->results_finish = PIM_QUERY_RESULTS_FINISH
+				(free_smartphone_pim_note_query_get_multiple_results_finish);
+			funcs->dispose = PIM_QUERY_DISPOSE(free_smartphone_pim_note_query_dispose_);
 			break;
 /* FIXME, wait the async version in freesmartphone APIs
 		case PHONEUI_PIM_DOMAIN_TASKS:
-			dispose_func = PIM_QUERY_DISPOSE(free_smartphone_pim_task_query_dispose_);
-			results_func = PIM_QUERY_RESULTS_FINISH(
-				free_smartphone_pim_task_query_get_multiple_results_finish);
+			funcs->query_proxy = PIM_QUERY_PROXY(free_smartphone_pim_get_task_query_proxy);
+			funcs->count = PIM_QUERY_COUNT(free_smartphone_pim_task_query_get_result_count);
+			funcs->count_finish = PIM_QUERY_COUNT_FINISH
+				(free_smartphone_pim_task_query_get_result_count_finish);
+			funcs->results = PIM_QUERY_RESULTS
+				(free_smartphone_pim_task_query_get_multiple_results);
+			funcs->results_finish = PIM_QUERY_RESULTS_FINISH
+				(free_smartphone_pim_task_query_get_multiple_results_finish);
+			funcs->dispose = PIM_QUERY_DISPOSE(free_smartphone_pim_task_query_dispose_);
 			break;
 */
 		default:
-			g_object_unref(pack->query);
-			free(pack);
-			return;
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* the query is done - it can't take more waiters */
+static void
+_query_waiters_deliver(struct _query_pack *pack, GError *error,
+		       GHashTable **results, int count)
+{
+	GSList *l;
+	struct _query_waiter *waiter;
+
+	if (pack->key && queries_in_flight &&
+	    g_hash_table_lookup(queries_in_flight, pack->key) == pack) {
+		g_hash_table_remove(queries_in_flight, pack->key);
 	}
 
-	results = results_func(pack->query, res, &count, &error);
-	dispose_func(pack->query, NULL, NULL);
+	/* every waiter gets its own references, the caller that fired
+	 * the query the original results */
+	for (l = pack->waiters; l; l = l->next) {
+		waiter = l->data;
+		if (!_cancellable_cancelled(waiter->cancellable)) {
+			waiter->callback(error, (results) ?
+					 _query_results_ref(results, count) : NULL,
+					 count, waiter->data);
+		}
+		_cancellable_free(waiter->cancellable);
+		free(waiter);
+	}
+	g_slist_free(pack->waiters);
+	pack->waiters = NULL;
+}
+
+static void
+_query_pack_deliver(struct _query_pack *pack, GError *error,
+		    GHashTable **results, int count)
+{
+	_query_waiters_deliver(pack, error, results, count);
+	if (_cancellable_cancelled(pack->cancellable)) {
+		_cancel_results_drop(results, count);
+	}
+	else if (pack->callback) {
+		pack->callback(error, results, count, pack->data);
+	}
+}
+
+/* nobody wants the results anymore */
+static gboolean
+_query_pack_abandoned(struct _query_pack *pack)
+{
+	GSList *l;
+
+	if (!_cancellable_cancelled(pack->cancellable))
+		return FALSE;
+	for (l = pack->waiters; l; l = l->next) {
+		if (!_cancellable_cancelled
+				(((struct _query_waiter *) l->data)->cancellable))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+static void
+_query_pack_free(struct _query_pack *pack)
+{
+	/* failed without an answer - don't leave the waiters hanging */
+	_query_waiters_deliver(pack, NULL, NULL, 0);
+	_cancellable_free(pack->cancellable);
+	free(pack->key);
+	free(pack);
+}
+
+static void
+_pim_query_results_callback(GObject *source, GAsyncResult *res, gpointer data)
+{
+	(void) source;
+	int count = 0;
+	GHashTable **results;
+	GError *error = NULL;
+	struct _query_pack *pack = data;
+	struct _pim_query_funcs funcs;
+
+	if (!_pim_query_funcs_get(pack->domain_type, &funcs)) {
+		g_object_unref(pack->query);
+		_query_pack_free(pack);
+		return;
+	}
+
+	results = funcs.results_finish(pack->query, res, &count, &error);
+	funcs.dispose(pack->query, NULL, NULL);
 	g_object_unref(pack->query);
 
 	g_debug("Query gave %d entries", count);
+	_latency_end(pack->started, "pim query", 1);
 
-	if (pack->callback) {
-		pack->callback(error, results, count, pack->data);
+	/* before the callbacks, they may drop the results */
+	if (!error && pack->cached) {
+		_query_cache_store(pack->domain_type, pack->cache_generation,
+				   pack->key, results, count);
 	}
 
+	_query_pack_deliver(pack, error, results, count);
+
 	if (error) {
 		g_error_free(error);
 	}
 
-	free(pack);
+	_query_pack_free(pack);
 }
 
+static void _pim_cursor_opened(struct PhoneuiPimCursor *cursor, void *query);
+
 static void
 _pim_query_callback(GObject *source, GAsyncResult *res, gpointer data)
 {
 	(void) source;
 	char *query_path = NULL;
 	GError *error = NULL;
-	void (*count_func)(void *query, GAsyncReadyCallback, gpointer);
-	void (*results_func)(void *query, int count, GAsyncReadyCallback, gpointer);
-	void *(*query_proxy)(DBusGConnection*, const char* busname, const char* path);
 	struct _query_pack *pack = data;
-
-	query_proxy = NULL;
-	count_func = NULL;
+	struct _pim_query_funcs funcs;
 
 	switch(pack->domain_type) {
 		case PHONEUI_PIM_DOMAIN_CALLS:
@@ -262,70 +509,53 @@ _pim_query_callback(GObject *source, GAsyncResult *res, gpointer data)
 
 	g_object_unref(pack->domain);
 
+	/* nothing to read results from - report that like any other error
+	 * instead of leaving the caller waiting */
+	if (!error && (!_pim_query_funcs_get(pack->domain_type, &funcs) ||
+		       !query_path)) {
+		error = g_error_new(DBUS_GERROR, DBUS_GERROR_FAILED,
+				    "No query object for domain %d",
+				    pack->domain_type);
+	}
+
 	if (error) {
 		g_warning("Query error: (%d) %s",
 			  error->code, error->message);
-		pack->callback(error, NULL, 0, pack->data);
+		if (pack->cursor) {
+			pack->cursor->opened(error, NULL, 0, pack->cursor->data);
+		}
+		else {
+			_query_pack_deliver(pack, error, NULL, 0);
+		}
 		g_error_free(error);
 		goto exit;
 	}
 
-	switch(pack->domain_type) {
-		case PHONEUI_PIM_DOMAIN_CALLS:
-			query_proxy = PIM_QUERY_PROXY(free_smartphone_pim_get_call_query_proxy);
-			count_func = PIM_QUERY_COUNT(free_smartphone_pim_call_query_get_result_count);
-			results_func = PIM_QUERY_RESULTS
-			               (free_smartphone_pim_call_query_get_multiple_results);
-			break;
-		case PHONEUI_PIM_DOMAIN_CONTACTS:
-			query_proxy = PIM_QUERY_PROXY(free_smartphone_pim_get_contact_query_proxy);
-			count_func = PIM_QUERY_COUNT(free_smartphone_pim_contact_query_get_result_count);
-			results_func = PIM_QUERY_RESULTS
-			               (free_smartphone_pim_contact_query_get_multiple_results);
-			break;
-/* FIXME, re-enable it when libfsoframework supports it again
-		case PHONEUI_PIM_DOMAIN_DATES:
-			query_proxy = PIM_QUERY_PROXY(free_smartphone_pim_get_date_query_proxy);
-			count_func = PIM_QUERY_COUNT(free_smartphone_pim_date_query_get_result_count);
-			results_func = PIM_QUERY_RESULTS
-			               (free_smartphone_pim_date_query_get_multiple_results);
-			break;
-*/
-		case PHONEUI_PIM_DOMAIN_MESSAGES:
-			query_proxy = PIM_QUERY_PROXY(free_smartphone_pim_get_message_query_proxy);
-			count_func = PIM_QUERY_COUNT(free_smartphone_pim_message_query_get_result_count);
-			results_func = PIM_QUERY_RESULTS
-			               (free_smartphone_pim_message_query_get_multiple_results);
-			break;
-		case PHONEUI_PIM_DOMAIN_NOTES:
-			query_proxy = PIM_QUERY_PROXY(free_smartphone_pim_get_note_query_proxy);
-			count_func = PIM_QUERY_COUNT(free_smartphone_pim_note_query_get_result_count);
-			results_func = PIM_QUERY_RESULTS
-			               (free_smartphone_pim_note_query_get_multiple_results);
-			break;
-/* FIXME, wait the async version in freesmartphone APIs
-		case PHONEUI_PIM_DOMAIN_TASKS:
-			query_proxy = PIM_QUERY_PROXY(free_smartphone_pim_get_task_query_proxy);
-			count_func = PIM_QUERY_COUNT(free_smartphone_pim_task_query_get_result_count);
-			results_func = PIM_QUERY_RESULTS
-			               (free_smartphone_pim_task_query_get_multiple_results);
-			break;
-*/
-		default:
-			goto exit;
+	pack->query = funcs.query_proxy(_dbus(), FSO_FRAMEWORK_PIM_ServiceDBusName, query_path);
+	free(query_path);
+
+	if (!pack->cursor && _query_pack_abandoned(pack)) {
+		/* don't transfer results nobody waits for */
+		g_debug("Query got cancelled, disposing it");
+		funcs.dispose(pack->query, NULL, NULL);
+		g_object_unref(pack->query);
+		_query_pack_free(pack);
+		return;
 	}
 
-	if (!query_proxy || !count_func || !query_path)
-		goto exit;
+	if (pack->cursor) {
+		_pim_cursor_opened(pack->cursor, pack->query);
+		_query_pack_free(pack);
+		return;
+	}
 
-	pack->query = query_proxy(_dbus(), FSO_FRAMEWORK_PIM_ServiceDBusName, query_path);
-	results_func(pack->query, -1, _pim_query_results_callback, pack);
-	free(query_path);
+	funcs.results(pack->query, -1, _pim_query_results_callback, pack);
 	return;
 
 exit:
 	if (query_path) free(query_path);
-	free(pack);
+	if (pack->cursor) free(pack->cursor);
+	_query_pack_free(pack);
 }
 
 static void
@@ -336,116 +566,355 @@ _pim_query_hashtable_clone_foreach_callback(void *k, void *v, void *data) {
 	GValue *new_value;
 
 	if (key && key[0] != '_') {
-		new_value = calloc(sizeof(GValue), 1);
-		g_value_init(new_value, G_VALUE_TYPE(value));
-		g_value_copy(value, new_value);
-		g_hash_table_insert(query, strdup(key), new_value);
+		new_value = _helpers_new_gvalue_copy(value);
+		if (new_value)
+			g_hash_table_insert(query, _helpers_field_intern(key),
+					    new_value);
 	}
 }
 
-void phoneui_utils_pim_query(enum PhoneUiPimDomain domain, const char *sortby,
+static int
+_pim_query_fire(struct _query_pack *pack, const char *sortby,
 	gboolean sortdesc, gboolean disjunction, int limit_start, int limit,
-	gboolean resolve_number, const GHashTable *options,
-	void (*callback)(GError *, GHashTable **, int, gpointer), gpointer data)
+	gboolean resolve_number, const GHashTable *options)
 {
-	struct _query_pack *pack;
 	GHashTable *query;
 	GValue *gval_tmp;
 	const char *path;
-	void *(*domain_get)(DBusGConnection*, const char* busname, const char* path);
+	void *domain_proxy;
 	void (*query_function)(void *domain, GHashTable *query, GAsyncReadyCallback, gpointer);
 
 	path = NULL;
+	domain_proxy = NULL;
 	query_function = NULL;
+	pack->started = _latency_begin();
 
-	switch(domain) {
+	switch(pack->domain_type) {
 		case PHONEUI_PIM_DOMAIN_CALLS:
 			path = FSO_FRAMEWORK_PIM_CallsServicePath;
 			query_function = PIM_QUERY_FUNCTION(free_smartphone_pim_calls_query);
-			domain_get = PIM_DOMAIN_PROXY(free_smartphone_pim_get_calls_proxy);
+			domain_proxy = _DBUS_PROXY(free_smartphone_pim_get_calls_proxy,
+					FSO_FRAMEWORK_PIM_ServiceDBusName, path);
 			break;
 		case PHONEUI_PIM_DOMAIN_CONTACTS:
 			path = FSO_FRAMEWORK_PIM_ContactsServicePath;
 			query_function = PIM_QUERY_FUNCTION(free_smartphone_pim_contacts_query);
-			domain_get = PIM_DOMAIN_PROXY(free_smartphone_pim_get_contacts_proxy);
+			domain_proxy = _DBUS_PROXY(free_smartphone_pim_get_contacts_proxy,
+					FSO_FRAMEWORK_PIM_ServiceDBusName, path);
 			break;
 /* FIXME, re-enable it when libfsoframework supports it again
 		case PHONEUI_PIM_DOMAIN_DATES:
 			path = FSO_FRAMEWORK_PIM_DatesServicePath;
 			query_function = PIM_QUERY_FUNCTION(free_smartphone_pim_dates_query);
-			domain_get = PIM_DOMAIN_PROXY(free_smartphone_pim_get_dates_proxy);
+			domain_proxy = _DBUS_PROXY(free_smartphone_pim_get_dates_proxy,
+					FSO_FRAMEWORK_PIM_ServiceDBusName, path);
 			break;
 */
 		case PHONEUI_PIM_DOMAIN_MESSAGES:
 			path = FSO_FRAMEWORK_PIM_MessagesServicePath;
 			query_function = PIM_QUERY_FUNCTION(free_smartphone_pim_messages_query);
-			domain_get = PIM_DOMAIN_PROXY(free_smartphone_pim_get_messages_proxy);
+			domain_proxy = _DBUS_PROXY(free_smartphone_pim_get_messages_proxy,
+					FSO_FRAMEWORK_PIM_ServiceDBusName, path);
 			break;
 		case PHONEUI_PIM_DOMAIN_NOTES:
 			path = FSO_FRAMEWORK_PIM_NotesServicePath;
 			query_function = PIM_QUERY_FUNCTION(free_smartphone_pim_notes_query);
-			domain_get = PIM_DOMAIN_PROXY(free_smartphone_pim_get_notes_proxy);
+			domain_proxy = _DBUS_PROXY(free_smartphone_pim_get_notes_proxy,
+					FSO_FRAMEWORK_PIM_ServiceDBusName, path);
 			break;
 /* FIXME, add the sync version in freesmartphone APIs
 		case PHONEUI_PIM_DOMAIN_TASKS:
 			path = FSO_FRAMEWORK_PIM_TasksServicePath;
 			query_function = PIM_QUERY_FUNCTION(free_smartphone_pim_tasks_query);
-			domain_get = PIM_DOMAIN_PROXY(free_smartphone_pim_get_tasks_proxy);
+			domain_proxy = _DBUS_PROXY(free_smartphone_pim_get_tasks_proxy,
+					FSO_FRAMEWORK_PIM_ServiceDBusName, path);
 			break;
 */
 		default:
-			return;
+			return 1;
 	}
 
-	if (!path || !query_function)
-		return;
+	if (!path || !query_function || !domain_proxy)
+		return 1;
 
-	query = g_hash_table_new_full(g_str_hash, g_str_equal,
-						   g_free, _helpers_free_gvalue);
-	if (!query)
-		return;
+	query = _helpers_new_field_table();
+	if (!query) {
+		g_object_unref(domain_proxy);
+		return 1;
+	}
 
 	if (sortby && strlen(sortby)) {
 		gval_tmp = _helpers_new_gvalue_string(sortby);
-		g_hash_table_insert(query, strdup("_sortby"), gval_tmp);
+		g_hash_table_insert(query, _helpers_field("_sortby"), gval_tmp);
 	}
 
 	if (sortdesc) {
 		gval_tmp = _helpers_new_gvalue_boolean(TRUE);
-		g_hash_table_insert(query, strdup("_sortdesc"), gval_tmp);
+		g_hash_table_insert(query, _helpers_field("_sortdesc"), gval_tmp);
 	}
 
 	if (disjunction) {
 		gval_tmp = _helpers_new_gvalue_boolean(TRUE);
-		g_hash_table_insert(query, strdup("_at_least_one"), gval_tmp);
+		g_hash_table_insert(query, _helpers_field("_at_least_one"), gval_tmp);
 	}
 
 	if (resolve_number) {
 		gval_tmp = _helpers_new_gvalue_boolean(TRUE);
-		g_hash_table_insert(query, strdup("_resolve_phonenumber"), gval_tmp);
+		g_hash_table_insert(query, _helpers_field("_resolve_phonenumber"), gval_tmp);
 	}
 
 	gval_tmp = _helpers_new_gvalue_int(limit_start);
-	g_hash_table_insert(query, strdup("_limit_start"), gval_tmp);
+	g_hash_table_insert(query, _helpers_field("_limit_start"), gval_tmp);
 	gval_tmp = _helpers_new_gvalue_int(limit);
-	g_hash_table_insert(query, strdup("_limit"), gval_tmp);
+	g_hash_table_insert(query, _helpers_field("_limit"), gval_tmp);
 
 	if (options) {
 		g_hash_table_foreach((GHashTable *)options,
 			_pim_query_hashtable_clone_foreach_callback, query);
 	}
 
-	pack = malloc(sizeof(*pack));
-	pack->domain_type = domain;
-	pack->callback = callback;
-	pack->data = data;
-	pack->domain = domain_get(_dbus(), FSO_FRAMEWORK_PIM_ServiceDBusName, path);
+	pack->domain = domain_proxy;
 	pack->query = NULL;
 
 	g_debug("Firing the query!");
 
 	query_function(pack->domain, query, _pim_query_callback, pack);
 	g_hash_table_unref(query);
+
+	return 0;
+}
+
+int phoneui_utils_pim_query(enum PhoneUiPimDomain domain, const char *sortby,
+	gboolean sortdesc, gboolean disjunction, int limit_start, int limit,
+	gboolean resolve_number, const GHashTable *options,
+	void (*callback)(GError *, GHashTable **, int, gpointer), gpointer data)
+{
+	int handle;
+	GError *error;
+	struct _query_pack *pack, *running;
+	struct _query_waiter *waiter;
+	struct _cancellable *cancellable;
+
+	/* without a handle the caller couldn't tell a running query from
+	 * one that never calls back */
+	cancellable = _cancellable_new();
+	if (!cancellable)
+		return 0;
+	handle = cancellable->handle;
+
+	pack = malloc(sizeof(*pack));
+	pack->domain_type = domain;
+	pack->cursor = NULL;
+	pack->callback = callback;
+	pack->data = data;
+	pack->waiters = NULL;
+	pack->cancellable = NULL;
+	pack->cache_generation = _query_cache_generation(domain);
+	pack->cached = _query_cache_enabled(domain);
+	pack->key = _query_key(domain, sortby, sortdesc, disjunction,
+			       limit_start, limit, resolve_number, options);
+
+	if (pack->cached && _query_cache_deliver(pack->key, cancellable,
+						 callback, data)) {
+		_query_pack_free(pack);
+		return handle;
+	}
+
+	if (!queries_in_flight) {
+		queries_in_flight = g_hash_table_new(g_str_hash, g_str_equal);
+	}
+	running = g_hash_table_lookup(queries_in_flight, pack->key);
+	if (running && callback) {
+		waiter = malloc(sizeof(*waiter));
+		if (waiter) {
+			g_debug("Attaching to the running identical query");
+			waiter->cancellable = cancellable;
+			waiter->callback = callback;
+			waiter->data = data;
+			running->waiters = g_slist_append(running->waiters,
+							  waiter);
+			_query_pack_free(pack);
+			return handle;
+		}
+	}
+
+	pack->cancellable = cancellable;
+	if (_pim_query_fire(pack, sortby, sortdesc, disjunction, limit_start,
+			    limit, resolve_number, options)) {
+		/* same as for a cursor, the caller learns it from the callback */
+		error = g_error_new(DBUS_GERROR, DBUS_GERROR_FAILED,
+				    "Can't query domain %d", domain);
+		_query_pack_deliver(pack, error, NULL, 0);
+		g_error_free(error);
+		_query_pack_free(pack);
+		return handle;
+	}
+	if (!running) {
+		g_hash_table_insert(queries_in_flight, pack->key, pack);
+	}
+	return handle;
+}
+
+static void
+_pim_cursor_free(struct PhoneuiPimCursor *cursor)
+{
+	cursor->funcs.dispose(cursor->query, NULL, NULL);
+	g_object_unref(cursor->query);
+	free(cursor);
+}
+
+static void
+_pim_cursor_count_callback(GObject *source, GAsyncResult *res, gpointer data)
+{
+	(void) source;
+	GError *error = NULL;
+	int count;
+	struct PhoneuiPimCursor *cursor = data;
+
+	count = cursor->funcs.count_finish(cursor->query, res, &error);
+	if (error) {
+		g_warning("Query count error: (%d) %s",
+			  error->code, error->message);
+		cursor->opened(error, NULL, 0, cursor->data);
+		g_error_free(error);
+		_pim_cursor_free(cursor);
+		return;
+	}
+
+	g_debug("Cursor opened on %d entries", count);
+	cursor->opened(NULL, cursor, count, cursor->data);
+}
+
+static void
+_pim_cursor_opened(struct PhoneuiPimCursor *cursor, void *query)
+{
+	cursor->query = query;
+	cursor->funcs.count(cursor->query, _pim_cursor_count_callback, cursor);
+}
+
+void
+phoneui_utils_pim_cursor_open(enum PhoneUiPimDomain domain, const char *sortby,
+	gboolean sortdesc, gboolean disjunction, gboolean resolve_number,
+	const GHashTable *options, int chunk_size,
+	void (*callback)(GError *, struct PhoneuiPimCursor *, int, gpointer),
+	gpointer data)
+{
+	GError *error;
+	struct _query_pack *pack;
+	struct PhoneuiPimCursor *cursor;
+
+	if (!callback) {
+		g_warning("phoneui_utils_pim_cursor_open without a callback!");
+		return;
+	}
+
+	cursor = malloc(sizeof(*cursor));
+	if (!_pim_query_funcs_get(domain, &cursor->funcs)) {
+		free(cursor);
+		error = g_error_new(DBUS_GERROR, DBUS_GERROR_NOT_SUPPORTED,
+				    "No cursors for domain %d", domain);
+		callback(error, NULL, 0, data);
+		g_error_free(error);
+		return;
+	}
+	cursor->query = NULL;
+	cursor->chunk_size = (chunk_size > 0) ? chunk_size : 1;
+	cursor->fetching = FALSE;
+	cursor->closed = FALSE;
+	cursor->opened = callback;
+	cursor->callback = NULL;
+	cursor->data = data;
+
+	pack = malloc(sizeof(*pack));
+	pack->domain_type = domain;
+	pack->cursor = cursor;
+	pack->callback = NULL;
+	pack->data = NULL;
+	pack->key = NULL;
+	pack->cached = FALSE;
+	pack->waiters = NULL;
+	pack->cancellable = NULL;
+
+	/* no limit - the entries are pulled chunk by chunk from the
+	 * query object by phoneui_utils_pim_cursor_fetch */
+	if (_pim_query_fire(pack, sortby, sortdesc, disjunction, 0, -1,
+			    resolve_number, options)) {
+		free(cursor);
+		_query_pack_free(pack);
+		error = g_error_new(DBUS_GERROR, DBUS_GERROR_FAILED,
+				    "Can't query domain %d", domain);
+		callback(error, NULL, 0, data);
+		g_error_free(error);
+	}
+}
+
+static void
+_pim_cursor_results_callback(GObject *source, GAsyncResult *res, gpointer data)
+{
+	(void) source;
+	int i, count = 0;
+	GHashTable **results;
+	GError *error = NULL;
+	struct PhoneuiPimCursor *cursor = data;
+
+	results = cursor->funcs.results_finish(cursor->query, res, &count, &error);
+	cursor->fetching = FALSE;
+
+	if (cursor->closed) {
+		/* closed while the chunk was on the way - drop it */
+		for (i = 0; results && i < count; i++) {
+			g_hash_table_unref(results[i]);
+		}
+		g_free(results);
+		if (error) {
+			g_error_free(error);
+		}
+		_pim_cursor_free(cursor);
+		return;
+	}
+
+	g_debug("Cursor fetched %d entries", count);
+	if (cursor->callback) {
+		cursor->callback(error, results, count, cursor->data);
+	}
+	if (error) {
+		g_error_free(error);
+	}
+}
+
+int
+phoneui_utils_pim_cursor_fetch(struct PhoneuiPimCursor *cursor, int count,
+	void (*callback)(GError *, GHashTable **, int, gpointer), gpointer data)
+{
+	if (!cursor || cursor->closed) {
+		return 1;
+	}
+	if (cursor->fetching) {
+		g_warning("Cursor is still fetching - not fetching again");
+		return 1;
+	}
+
+	cursor->fetching = TRUE;
+	cursor->callback = callback;
+	cursor->data = data;
+	cursor->funcs.results(cursor->query,
+			(count > 0) ? count : cursor->chunk_size,
+			_pim_cursor_results_callback, cursor);
+	return 0;
+}
+
+void
+phoneui_utils_pim_cursor_close(struct PhoneuiPimCursor *cursor)
+{
+	if (!cursor || cursor->closed) {
+		return;
+	}
+
+	cursor->closed = TRUE;
+	/* if a chunk is on the way the cursor is freed when it arrives */
+	if (!cursor->fetching) {
+		_pim_cursor_free(cursor);
+	}
 }
 
 static GHashTable *
@@ -453,32 +922,122 @@ _create_opimd_message(const char *number, const char *message)
 {
 	/* TODO: add timzone */
 
-	GHashTable *message_opimd =
-		g_hash_table_new_full(g_str_hash, g_str_equal,
-				      NULL, _helpers_free_gvalue);
+	GHashTable *message_opimd = _helpers_new_field_table();
 	GValue *tmp;
 
 	tmp = _helpers_new_gvalue_string(number);
-	g_hash_table_insert(message_opimd, "Peer", tmp);
+	g_hash_table_insert(message_opimd, _helpers_field("Peer"), tmp);
 
 	tmp = _helpers_new_gvalue_string("out");
-	g_hash_table_insert(message_opimd, "Direction", tmp);
+	g_hash_table_insert(message_opimd, _helpers_field("Direction"), tmp);
 
 	tmp = _helpers_new_gvalue_string("SMS");
-	g_hash_table_insert(message_opimd, "Source", tmp);
+	g_hash_table_insert(message_opimd, _helpers_field("Source"), tmp);
 
 	tmp = _helpers_new_gvalue_string(message);
-	g_hash_table_insert(message_opimd, "Content", tmp);
+	g_hash_table_insert(message_opimd, _helpers_field("Content"), tmp);
 
 	tmp = _helpers_new_gvalue_boolean(TRUE);
-	g_hash_table_insert(message_opimd, "New", tmp);
+	g_hash_table_insert(message_opimd, _helpers_field("New"), tmp);
 
 	tmp = _helpers_new_gvalue_int(time(NULL));
-	g_hash_table_insert(message_opimd, "Timestamp", tmp);
+	g_hash_table_insert(message_opimd, _helpers_field("Timestamp"), tmp);
 
 	return message_opimd;
 }
 
+static void _sms_batch_fill(struct _sms_send_batch *batch);
+
+static void
+_sms_batch_report(struct _sms_send_batch *batch)
+{
+	struct _sms_send_pack *pack;
+
+	/* report strictly in recipient order */
+	while (batch->reported < batch->packs->len) {
+		pack = g_ptr_array_index(batch->packs, batch->reported);
+		if (!pack->done)
+			break;
+		if (batch->progress) {
+			batch->progress(pack->error, pack->index, pack->reference,
+					pack->timestamp, batch->data);
+		}
+		if (pack->error) {
+			g_error_free(pack->error);
+		}
+		free(pack->timestamp);
+		free(pack->number);
+		free(pack->message);
+		free(pack->pim_path);
+		free(pack);
+		g_ptr_array_index(batch->packs, batch->reported) = NULL;
+		batch->reported++;
+	}
+}
+
+static void _sms_send_callback(GObject *source, GAsyncResult *res, gpointer data);
+
+static void
+_sms_outbox_schedule()
+{
+	int delay;
+
+	if (sms_replay_source)
+		return;
+	if (!_outbox_pending_count()) {
+		sms_replay_round = 0;
+		return;
+	}
+	delay = SMS_REPLAY_DELAY << MIN(sms_replay_round, 6);
+	sms_replay_round++;
+	g_message("Resending failed SMS from the outbox in %ds", delay);
+	sms_replay_source = g_timeout_add_seconds(delay, _sms_outbox_replay,
+						  NULL);
+}
+
+/* called once both sending and storing are through */
+static void
+_sms_send_finish(struct _sms_send_pack *pack)
+{
+	int failures;
+	struct _sms_send_batch *batch = pack->batch;
+
+	if (pack->pim_path) {
+		phoneui_utils_message_set_sent_status(pack->pim_path,
+						      !pack->error, NULL, NULL);
+	}
+	failures = (pack->error) ? _outbox_failed(pack->outbox_id) : 0;
+	if (failures && failures <= sms_replays) {
+		/* stays in the outbox for a later attempt */
+		_sms_outbox_schedule();
+	}
+	else {
+		_outbox_done(pack->outbox_id, !pack->error);
+	}
+
+	if (pack->error) {
+		batch->failed++;
+	}
+	else {
+		batch->sent++;
+	}
+	pack->done = TRUE;
+	batch->running--;
+
+	_sms_batch_report(batch);
+	_sms_batch_fill(batch);
+}
+
+static gboolean
+_sms_send_retry(gpointer data)
+{
+	struct _sms_send_pack *pack = data;
+
+	free_smartphone_gsm_sms_send_text_message(pack->batch->sms, pack->number,
+				pack->message, FALSE, _sms_send_callback, pack);
+	return FALSE;
+}
+
 static void
 _sms_send_callback(GObject *source, GAsyncResult *res, gpointer data)
 {
@@ -486,30 +1045,56 @@ _sms_send_callback(GObject *source, GAsyncResult *res, gpointer data)
 	GError *error = NULL;
 	char *timestamp = NULL;
 	struct _sms_send_pack *pack = data;
-	int reference;
+	struct _sms_send_batch *batch = pack->batch;
+	int reference = 0;
 
-	free_smartphone_gsm_sms_send_text_message_finish(pack->sms, res,
+	free_smartphone_gsm_sms_send_text_message_finish(batch->sms, res,
 						&reference, &timestamp, &error);
 
-	if (pack->pim_path) {
-		phoneui_utils_message_set_sent_status(pack->pim_path, !error, NULL, NULL);
-		free(pack->pim_path);
-	}
-
-	if (pack->callback) {
-		pack->callback(error, reference, timestamp, pack->data);
-	}
-	if (timestamp) {
+	if (error && pack->attempts < sms_retries) {
+		pack->attempts++;
+		g_warning("Error %d sending message: %s - retrying in %ds",
+			  error->code, error->message, 1 << pack->attempts);
+		g_error_free(error);
 		free(timestamp);
+		g_timeout_add_seconds(1 << pack->attempts, _sms_send_retry, pack);
+		return;
 	}
+
 	if (error) {
 		g_warning("Error %d sending message: %s\n", error->code, error->message);
+	}
+	pack->error = error;
+	pack->reference = reference;
+	pack->timestamp = timestamp;
+	pack->sent = TRUE;
+	if (!pack->storing) {
+		_sms_send_finish(pack);
+	}
+}
+
+static void
+_opimd_message_stored(GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+	(void)source_object;
+	struct _sms_send_pack *pack = user_data;
+	char *msg_path = NULL;
+	GError *error = NULL;
+
+	msg_path = free_smartphone_pim_messages_add_finish(pack->batch->pim_messages,
+				res, &error);
+	if (!error && msg_path) {
+		pack->pim_path = msg_path;
+		_outbox_saved(pack->outbox_id, msg_path);
+	}
+	else if (error) {
+		g_warning("Error %d saving message: %s\n", error->code, error->message);
 		g_error_free(error);
 	}
-	g_object_unref(pack->pim_messages);
-	g_object_unref(pack->sms);
-	free(pack->number);
-	free(pack);
+	pack->storing = FALSE;
+	if (pack->sent) {
+		_sms_send_finish(pack);
+	}
 }
 
 static void
@@ -517,6 +1102,7 @@ _opimd_message_added(GObject *source_object, GAsyncResult *res, gpointer user_da
 {
 	(void)source_object;
 	struct _sms_send_pack *pack = user_data;
+	struct _sms_send_batch *batch = pack->batch;
 	char *msg_path = NULL;
 	GError *error = NULL;
 
@@ -524,11 +1110,13 @@ _opimd_message_added(GObject *source_object, GAsyncResult *res, gpointer user_da
 	 * is ok, even if it didn't save. We really need to fix that,
 	 * we should verify if glib's callbacks work */
 
-	msg_path = free_smartphone_pim_messages_add_finish(pack->pim_messages, res,
+	msg_path = free_smartphone_pim_messages_add_finish(batch->pim_messages, res,
 				&error);
 
-	if (!error && msg_path)
+	if (!error && msg_path) {
 		pack->pim_path = msg_path;
+		_outbox_saved(pack->outbox_id, msg_path);
+	}
 	else if (error) {
 		g_warning("Error %d saving message: %s\n", error->code, error->message);
 		g_error_free(error);
@@ -536,46 +1124,160 @@ _opimd_message_added(GObject *source_object, GAsyncResult *res, gpointer user_da
 		 * to the pack; then do the proper callback. */
 	}
 
-	free_smartphone_gsm_sms_send_text_message(pack->sms, pack->number,
+	free_smartphone_gsm_sms_send_text_message(batch->sms, pack->number,
 				pack->message, FALSE, _sms_send_callback, pack);
 }
 
 static void
 _sms_message_send(struct _sms_send_pack *pack)
 {
-	if (pack->pim_messages) {
+	struct _sms_send_batch *batch = pack->batch;
+
+	/* replayed ones might have been saved already */
+	if (batch->pim_messages && !pack->pim_path && sms_store_concurrent) {
+		GHashTable *message_opimd = _create_opimd_message(pack->number, pack->message);
+		pack->storing = TRUE;
+		free_smartphone_pim_messages_add(batch->pim_messages, message_opimd,
+					_opimd_message_stored, pack);
+		g_hash_table_unref(message_opimd);
+		free_smartphone_gsm_sms_send_text_message(batch->sms, pack->number,
+				pack->message, FALSE, _sms_send_callback, pack);
+	} else if (batch->pim_messages && !pack->pim_path) {
 		GHashTable *message_opimd = _create_opimd_message(pack->number, pack->message);
-		free_smartphone_pim_messages_add(pack->pim_messages, message_opimd,
+		free_smartphone_pim_messages_add(batch->pim_messages, message_opimd,
 					_opimd_message_added, pack);
 		g_hash_table_unref(message_opimd);
 	} else {
-		free_smartphone_gsm_sms_send_text_message(pack->sms, pack->number,
+		free_smartphone_gsm_sms_send_text_message(batch->sms, pack->number,
 				pack->message, FALSE, _sms_send_callback, pack);
 	}
 }
 
+static void
+_sms_batch_fill(struct _sms_send_batch *batch)
+{
+	while (batch->running < sms_window && batch->next < batch->packs->len) {
+		batch->running++;
+		_sms_message_send(g_ptr_array_index(batch->packs, batch->next++));
+	}
+	if (batch->running > 0 || batch->reported < batch->packs->len)
+		return;
+
+	g_message("SMS sending done: %d sent, %d failed",
+		  batch->sent, batch->failed);
+	if (batch->summary) {
+		batch->summary(batch->sent, batch->failed, batch->data);
+	}
+	if (batch->pim_messages) {
+		g_object_unref(batch->pim_messages);
+	}
+	g_object_unref(batch->sms);
+	g_ptr_array_free(batch->packs, TRUE);
+	free(batch);
+}
+
+static struct _sms_send_pack *
+_sms_send_pack_new(struct _sms_send_batch *batch, int index, int outbox_id,
+		   char *number, const char *message, const char *pim_path)
+{
+	struct _sms_send_pack *pack;
+
+	pack = malloc(sizeof(*pack));
+	pack->batch = batch;
+	pack->index = index;
+	pack->outbox_id = outbox_id;
+	pack->attempts = 0;
+	pack->number = number;
+	/* sending outlives the caller's buffer */
+	pack->message = strdup(message);
+	pack->pim_path = (pim_path) ? strdup(pim_path) : NULL;
+	pack->storing = FALSE;
+	pack->sent = FALSE;
+	pack->done = FALSE;
+	pack->error = NULL;
+	pack->reference = 0;
+	pack->timestamp = NULL;
+	g_ptr_array_add(batch->packs, pack);
+	return pack;
+}
+
+static struct _sms_send_batch *
+_sms_send_batch_new(void (*progress)(GError *, int, int, const char *, gpointer),
+		    void (*summary)(int, int, gpointer), gpointer data)
+{
+	struct _sms_send_batch *batch;
+
+	batch = malloc(sizeof(*batch));
+	if (!batch) {
+		return NULL;
+	}
+	batch->sms = _DBUS_PROXY(free_smartphone_gsm_get_s_m_s_proxy,
+					FSO_FRAMEWORK_GSM_ServiceDBusName,
+					FSO_FRAMEWORK_GSM_DeviceServicePath);
+	batch->pim_messages = _DBUS_PROXY(free_smartphone_pim_get_messages_proxy,
+					FSO_FRAMEWORK_PIM_ServiceDBusName,
+					FSO_FRAMEWORK_PIM_MessagesServicePath);
+	batch->packs = g_ptr_array_new();
+	batch->next = 0;
+	batch->reported = 0;
+	batch->running = 0;
+	batch->sent = 0;
+	batch->failed = 0;
+	batch->progress = progress;
+	batch->summary = summary;
+	batch->data = data;
+	return batch;
+}
+
+static void
+_sms_outbox_add(int id, const char *number, const char *message,
+		const char *pim_path, gpointer data)
+{
+	struct _sms_send_batch *batch = data;
+
+	g_message("Resending SMS to %s from the outbox", number);
+	_sms_send_pack_new(batch, batch->packs->len, id, strdup(number),
+			   message, pim_path);
+}
+
+static gboolean
+_sms_outbox_replay(gpointer data)
+{
+	(void) data;
+	struct _sms_send_batch *batch;
+
+	sms_replay_source = 0;
+	/* might all have been sent meanwhile */
+	if (!_outbox_pending_count())
+		return FALSE;
+	batch = _sms_send_batch_new(NULL, NULL, NULL);
+	if (batch) {
+		_outbox_pending_foreach(_sms_outbox_add, batch);
+		_sms_batch_fill(batch);
+	}
+	return FALSE;
+}
+
 int
-phoneui_utils_sms_send(const char *message, GPtrArray * recipients, void (*callback)
-		(GError *, int transaction_index, const char *timestamp, gpointer),
+phoneui_utils_sms_send_full(const char *message, GPtrArray *recipients,
+		void (*progress)(GError *, int recipient, int reference,
+				 const char *timestamp, gpointer),
+		void (*summary)(int sent, int failed, gpointer),
 		gpointer data)
 {
 	unsigned int i;
-	struct _sms_send_pack *pack;
-	FreeSmartphoneGSMSMS *sms;
-	FreeSmartphonePIMMessages *pim_messages;
+	struct _sms_send_batch *batch;
 	GHashTable *properties;
 	char *number;
 
-	if (!recipients) {
+	if (!recipients || !message) {
 		return 1;
 	}
 
-	sms = free_smartphone_gsm_get_s_m_s_proxy(_dbus(),
-					FSO_FRAMEWORK_GSM_ServiceDBusName,
-					FSO_FRAMEWORK_GSM_DeviceServicePath);
-	pim_messages = free_smartphone_pim_get_messages_proxy(_dbus(),
-					FSO_FRAMEWORK_PIM_ServiceDBusName,
-					FSO_FRAMEWORK_PIM_MessagesServicePath);
+	batch = _sms_send_batch_new(progress, summary, data);
+	if (!batch) {
+		return 1;
+	}
 
 	/* cycle through all the recipients */
 	for (i = 0; i < recipients->len; i++) {
@@ -586,19 +1288,50 @@ phoneui_utils_sms_send(const char *message, GPtrArray * recipients, void (*callb
 			continue;
 		}
 		g_message("%d.\t%s", i + 1, number);
-		pack = malloc(sizeof(*pack));
-		pack->callback = callback;
-		pack->data = data;
-		pack->sms = g_object_ref(sms);
-		pack->pim_messages = g_object_ref(pim_messages);
-		pack->pim_path = NULL;
-		pack->message = message;
-		pack->number = number;
-		_sms_message_send(pack);
-	}
-	g_object_unref(sms);
-	g_object_unref(pim_messages);
+		_sms_send_pack_new(batch, i, _outbox_queued(number, message),
+				   number, message, NULL);
+	}
 
+	_sms_batch_fill(batch);
+	return 0;
+}
+
+static void
+_sms_send_legacy_progress(GError *error, int recipient, int reference,
+			  const char *timestamp, gpointer data)
+{
+	(void) recipient;
+	struct _sms_send_legacy_pack *pack = data;
+
+	if (pack->callback) {
+		pack->callback(error, reference, timestamp, pack->data);
+	}
+}
+
+static void
+_sms_send_legacy_summary(int sent, int failed, gpointer data)
+{
+	(void) sent;
+	(void) failed;
+
+	free(data);
+}
+
+int
+phoneui_utils_sms_send(const char *message, GPtrArray * recipients, void (*callback)
+		(GError *, int transaction_index, const char *timestamp, gpointer),
+		gpointer data)
+{
+	struct _sms_send_legacy_pack *pack;
+
+	pack = malloc(sizeof(*pack));
+	pack->callback = callback;
+	pack->data = data;
+	if (phoneui_utils_sms_send_full(message, recipients,
+			_sms_send_legacy_progress, _sms_send_legacy_summary, pack)) {
+		free(pack);
+		return 1;
+	}
 	return 0;
 }
 
@@ -684,7 +1417,7 @@ phoneui_utils_usage_suspend(void (*callback) (GError *, gpointer), gpointer data
 	pack = malloc(sizeof(*pack));
 	pack->callback = callback;
 	pack->data = data;
-	pack->usage = free_smartphone_get_usage_proxy(_dbus(),
+	pack->usage = _DBUS_PROXY(free_smartphone_get_usage_proxy,
 					FSO_FRAMEWORK_USAGE_ServiceDBusName,
 					FSO_FRAMEWORK_USAGE_ServicePathPrefix);
 	free_smartphone_usage_suspend(pack->usage, _suspend_callback, pack);
@@ -716,7 +1449,7 @@ phoneui_utils_usage_shutdown(void (*callback) (GError *, gpointer), gpointer dat
 	pack = malloc(sizeof(*pack));
 	pack->callback = callback;
 	pack->data = data;
-	pack->usage = free_smartphone_get_usage_proxy(_dbus(),
+	pack->usage = _DBUS_PROXY(free_smartphone_get_usage_proxy,
 					FSO_FRAMEWORK_USAGE_ServiceDBusName,
 					FSO_FRAMEWORK_USAGE_ServicePathPrefix);
 	free_smartphone_usage_shutdown(pack->usage, _shutdown_callback, pack);
@@ -751,7 +1484,7 @@ phoneui_utils_idle_set_state(FreeSmartphoneDeviceIdleState state,
 	pack = malloc(sizeof(*pack));
 	pack->callback = callback;
 	pack->data = data;
-	pack->idle = free_smartphone_device_get_idle_notifier_proxy(_dbus(),
+	pack->idle = _DBUS_PROXY(free_smartphone_device_get_idle_notifier_proxy,
 				FSO_FRAMEWORK_DEVICE_ServiceDBusName,
 				FSO_FRAMEWORK_DEVICE_IdleNotifierServicePath"/0");
 	free_smartphone_device_idle_notifier_set_state(pack->idle, state,
@@ -786,7 +1519,7 @@ phoneui_utils_resources_get_resource_policy(const char *name,
 	pack = malloc(sizeof(*pack));
 	pack->callback = callback;
 	pack->data = data;
-	pack->usage = free_smartphone_get_usage_proxy(_dbus(),
+	pack->usage = _DBUS_PROXY(free_smartphone_get_usage_proxy,
 					FSO_FRAMEWORK_USAGE_ServiceDBusName,
 					FSO_FRAMEWORK_USAGE_ServicePathPrefix);
 	free_smartphone_usage_get_resource_policy(pack->usage, name,
@@ -822,59 +1555,59 @@ phoneui_utils_resources_set_resource_policy(const char *name,
 	pack = malloc(sizeof(*pack));
 	pack->callback = callback;
 	pack->data = data;
-	pack->usage = free_smartphone_get_usage_proxy(_dbus(),
+	pack->usage = _DBUS_PROXY(free_smartphone_get_usage_proxy,
 					FSO_FRAMEWORK_USAGE_ServiceDBusName,
 					FSO_FRAMEWORK_USAGE_ServicePathPrefix);
 	free_smartphone_usage_set_resource_policy(pack->usage, name, policy,
 						  _set_policy_callback, pack);
 }
 
-void
+int
 phoneui_utils_calls_query(const char *sortby, gboolean sortdesc,
 			gboolean disjunction, int limit_start, int limit,
 			gboolean resolve_number, const GHashTable *options,
 			void (*callback)(GError *, GHashTable **, int, gpointer),
 			gpointer data)
 {
-	phoneui_utils_pim_query(PHONEUI_PIM_DOMAIN_CALLS, sortby, sortdesc, disjunction,
+	return phoneui_utils_pim_query(PHONEUI_PIM_DOMAIN_CALLS, sortby, sortdesc, disjunction,
 				limit_start, limit, resolve_number, options, callback, data);
 }
 
-void
+int
 phoneui_utils_calls_get_full(const char *sortby, gboolean sortdesc,
 			int limit_start, int limit, gboolean resolve_number,
 			const char *direction, int answered,
 			void (*callback) (GError *, GHashTable **, int, gpointer),
 			gpointer data)
 {
-
-	GHashTable *qry = g_hash_table_new_full(g_str_hash, g_str_equal,
-						NULL, _helpers_free_gvalue);
+	int handle;
+	GHashTable *qry = _helpers_new_field_table();
 
 	if (direction && (!strcmp(direction, "in") || !strcmp(direction, "out"))) {
-		g_hash_table_insert(qry, "Direction",
+		g_hash_table_insert(qry, _helpers_field("Direction"),
 		    _helpers_new_gvalue_string(direction));
 	}
 
 	if (answered > -1) {
-		g_hash_table_insert(qry, "Answered",
+		g_hash_table_insert(qry, _helpers_field("Answered"),
 			    _helpers_new_gvalue_boolean(answered));
 	}
 
-	phoneui_utils_calls_query(sortby, sortdesc, FALSE, limit_start, limit,
-				resolve_number, qry, callback, data);
+	handle = phoneui_utils_calls_query(sortby, sortdesc, FALSE,
+			limit_start, limit, resolve_number, qry, callback, data);
 
 	g_hash_table_unref(qry);
+	return handle;
 }
 
-void
+int
 phoneui_utils_calls_get(int *count,
 			void (*callback) (GError *, GHashTable **, int, gpointer),
 			gpointer data)
 {
 	int limit = (count && *count > 0) ? *count : -1;
 
-	phoneui_utils_calls_get_full("Timestamp", TRUE, 0, limit, TRUE, NULL, -1, callback, data);
+	return phoneui_utils_calls_get_full("Timestamp", TRUE, 0, limit, TRUE, NULL, -1, callback, data);
 }
 
 static void
@@ -887,34 +1620,63 @@ _call_get_callback(GObject *source, GAsyncResult *res, gpointer data)
 
 	content = free_smartphone_pim_call_get_content_finish
 						(pack->call, res, &error);
-	pack->callback(error, content, pack->data);
+	if (!_cancellable_cancelled(pack->cancellable)) {
+		pack->callback(error, content, pack->data);
+	}
 	if (error) {
 		g_error_free(error);
 	}
 	if (content) {
 		g_hash_table_unref(content);
 	}
+	_cancellable_free(pack->cancellable);
 	g_object_unref(pack->call);
 	free(pack);
 }
 
-int
-phoneui_utils_call_get(const char *call_path,
-		       void (*callback)(GError *, GHashTable*, gpointer),
-		       gpointer data)
+static struct _call_get_pack *
+_call_get(const char *call_path, gboolean cancellable,
+	  void (*callback)(GError *, GHashTable*, gpointer), gpointer data)
 {
 	struct _call_get_pack *pack;
 
 	pack = malloc(sizeof(*pack));
+	if (!pack)
+		return NULL;
+	pack->cancellable = NULL;
+	if (cancellable && !(pack->cancellable = _cancellable_new())) {
+		free(pack);
+		return NULL;
+	}
 	pack->data = data;
 	pack->callback = callback;
 	pack->call = free_smartphone_pim_get_call_proxy(_dbus(),
 				FSO_FRAMEWORK_PIM_ServiceDBusName, call_path);
 	g_debug("Getting data of call with path: %s", call_path);
 	free_smartphone_pim_call_get_content(pack->call, _call_get_callback, pack);
+	return pack;
+}
+
+int
+phoneui_utils_call_get(const char *call_path,
+		       void (*callback)(GError *, GHashTable*, gpointer),
+		       gpointer data)
+{
+	_call_get(call_path, FALSE, callback, data);
 	return (0);
 }
 
+int
+phoneui_utils_call_get_cancellable(const char *call_path,
+		       void (*callback)(GError *, GHashTable*, gpointer),
+		       gpointer data)
+{
+	struct _call_get_pack *pack;
+
+	pack = _call_get(call_path, TRUE, callback, data);
+	return (pack) ? pack->cancellable->handle : 0;
+}
+
 static void
 _pdp_activate_callback(GObject *source, GAsyncResult *res, gpointer data)
 {
@@ -961,7 +1723,7 @@ phoneui_utils_pdp_activate_context(void (*callback)(GError *, gpointer),
 	pack = malloc(sizeof(*pack));
 	pack->callback = callback;
 	pack->data = userdata;
-	pack->pdp = free_smartphone_gsm_get_p_d_p_proxy(_dbus(),
+	pack->pdp = _DBUS_PROXY(free_smartphone_gsm_get_p_d_p_proxy,
 					FSO_FRAMEWORK_GSM_ServiceDBusName,
 					FSO_FRAMEWORK_GSM_DeviceServicePath);
 
@@ -978,7 +1740,7 @@ phoneui_utils_pdp_deactivate_context(void (*callback)(GError *, gpointer),
 	pack = malloc(sizeof(*pack));
 	pack->callback = callback;
 	pack->data = userdata;
-	pack->pdp = free_smartphone_gsm_get_p_d_p_proxy(_dbus(),
+	pack->pdp = _DBUS_PROXY(free_smartphone_gsm_get_p_d_p_proxy,
 					FSO_FRAMEWORK_GSM_ServiceDBusName,
 					FSO_FRAMEWORK_GSM_DeviceServicePath);
 
@@ -1016,7 +1778,7 @@ phoneui_utils_pdp_get_credentials(void (*callback)(GError *, const char *,
 	pack = malloc(sizeof(*pack));
 	pack->callback = callback;
 	pack->data = data;
-	pack->pdp = free_smartphone_gsm_get_p_d_p_proxy(_dbus(),
+	pack->pdp = _DBUS_PROXY(free_smartphone_gsm_get_p_d_p_proxy,
 					FSO_FRAMEWORK_GSM_ServiceDBusName,
 					FSO_FRAMEWORK_GSM_DeviceServicePath);
 	free_smartphone_gsm_pdp_get_credentials
@@ -1035,6 +1797,11 @@ _network_start_sharing_cb(GObject *source, GAsyncResult *res, gpointer data)
 	if (pack->callback) {
 		pack->callback(error, pack->data);
 	}
+	if (error) {
+		g_error_free(error);
+	}
+	g_object_unref(pack->network);
+	free(pack);
 }
 
 void
@@ -1045,7 +1812,7 @@ phoneui_utils_network_start_connection_sharing(const char *iface,
 	pack = malloc(sizeof(*pack));
 	pack->callback = callback;
 	pack->data = data;
-	pack->network = free_smartphone_get_network_proxy(_dbus(),
+	pack->network = _DBUS_PROXY(free_smartphone_get_network_proxy,
 					FSO_FRAMEWORK_NETWORK_ServiceDBusName,
 					FSO_FRAMEWORK_NETWORK_ServicePathPrefix);
 	free_smartphone_network_start_connection_sharing_with_interface
@@ -1064,6 +1831,11 @@ _network_stop_sharing_cb(GObject *source, GAsyncResult *res, gpointer data)
 	if (pack->callback) {
 		pack->callback(error, pack->data);
 	}
+	if (error) {
+		g_error_free(error);
+	}
+	g_object_unref(pack->network);
+	free(pack);
 }
 
 void
@@ -1074,7 +1846,7 @@ phoneui_utils_network_stop_connection_sharing(const char *iface,
 	pack = malloc(sizeof(*pack));
 	pack->callback = callback;
 	pack->data = data;
-	pack->network = free_smartphone_get_network_proxy(_dbus(),
+	pack->network = _DBUS_PROXY(free_smartphone_get_network_proxy,
 					FSO_FRAMEWORK_NETWORK_ServiceDBusName,
 					FSO_FRAMEWORK_NETWORK_ServicePathPrefix);
 	free_smartphone_network_stop_connection_sharing_with_interface
@@ -1110,9 +1882,14 @@ phoneui_utils_get_offline_mode(void (*callback)(GError *, gboolean, gpointer),
 	pack->callback = callback;
 	pack->data = userdata;
 
-	bus = dbus_g_bus_get(DBUS_BUS_SYSTEM, &error);
-	if (error) {
-		callback(error, FALSE, userdata);
+	bus = _dbus();
+	if (!bus) {
+		error = g_error_new(DBUS_GERROR, DBUS_GERROR_NO_SERVER,
+				    "Not connected to the bus");
+		if (callback)
+			callback(error, FALSE, userdata);
+		g_error_free(error);
+		free(pack);
 		return;
 	}
 	phonefsod = dbus_g_proxy_new_for_name(bus, "org.shr.phonefso",
@@ -1150,9 +1927,14 @@ phoneui_utils_set_offline_mode(gboolean offline,
 	pack->callback = callback;
 	pack->data = userdata;
 
-	bus = dbus_g_bus_get(DBUS_BUS_SYSTEM, &error);
-	if (error) {
-		callback(error, userdata);
+	bus = _dbus();
+	if (!bus) {
+		error = g_error_new(DBUS_GERROR, DBUS_GERROR_NO_SERVER,
+				    "Not connected to the bus");
+		if (callback)
+			callback(error, userdata);
+		g_error_free(error);
+		free(pack);
 		return;
 	}
 	phonefsod = dbus_g_proxy_new_for_name(bus, "org.shr.phonefso",
@@ -1192,9 +1974,14 @@ phoneui_utils_set_pin(const char *pin, gboolean save,
 	pack->callback = callback;
 	pack->data = userdata;
 
-	bus = dbus_g_bus_get(DBUS_BUS_SYSTEM, &error);
-	if (error) {
-		callback(error, userdata);
+	bus = _dbus();
+	if (!bus) {
+		error = g_error_new(DBUS_GERROR, DBUS_GERROR_NO_SERVER,
+				    "Not connected to the bus");
+		if (callback)
+			callback(error, userdata);
+		g_error_free(error);
+		free(pack);
 		return;
 	}
 	phonefsod = dbus_g_proxy_new_for_name(bus, "org.shr.phonefso",
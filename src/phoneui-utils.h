@@ -80,7 +80,20 @@ enum PhoneUiPimDomain {
 	PHONEUI_PIM_DOMAIN_TASKS,
 };
 
-void phoneui_utils_pim_query(enum PhoneUiPimDomain domain, const char *sortby, gboolean sortdesc, gboolean disjunction, int limit_start, int limit, gboolean resolve_number, const GHashTable *options, void (*callback)(GError *, GHashTable **, int, gpointer), gpointer data);
+/* the query functions return a handle for phoneui_utils_cancel, 0 if the
+ * query couldn't be started - the callback is never called then. A query
+ * that fails after it started reports the error through its callback.
+ * A cancelled query never calls back.
+ * The result tables are shared with other callers of the same query and
+ * with the [pim] cache - release them as usual but never modify them */
+int phoneui_utils_pim_query(enum PhoneUiPimDomain domain, const char *sortby, gboolean sortdesc, gboolean disjunction, int limit_start, int limit, gboolean resolve_number, const GHashTable *options, void (*callback)(GError *, GHashTable **, int, gpointer), gpointer data);
+
+/* paged access to the results of a query: open delivers the cursor and the
+ * number of entries, every fetch delivers the next chunk (count 0 at the end) */
+struct PhoneuiPimCursor;
+void phoneui_utils_pim_cursor_open(enum PhoneUiPimDomain domain, const char *sortby, gboolean sortdesc, gboolean disjunction, gboolean resolve_number, const GHashTable *options, int chunk_size, void (*callback)(GError *, struct PhoneuiPimCursor *, int, gpointer), gpointer data);
+int phoneui_utils_pim_cursor_fetch(struct PhoneuiPimCursor *cursor, int count, void (*callback)(GError *, GHashTable **, int, gpointer), gpointer data);
+void phoneui_utils_pim_cursor_close(struct PhoneuiPimCursor *cursor);
 
 gchar *phoneui_utils_get_user_home_prefix();
 gchar *phoneui_utils_get_user_home_code();
@@ -90,6 +103,14 @@ int phoneui_utils_sms_send(const char *message, GPtrArray * recipients, void (*c
 		(GError *, int transaction_index, const char *timestamp, gpointer),
 		  void *userdata);
 
+/* Sends to at most [sms] window recipients at the same time. progress is
+ * called once per recipient, in recipient order, summary after the last. */
+int phoneui_utils_sms_send_full(const char *message, GPtrArray *recipients,
+		void (*progress)(GError *, int recipient, int reference,
+				 const char *timestamp, gpointer),
+		void (*summary)(int sent, int failed, gpointer),
+		gpointer data);
+
 
 
 void phoneui_utils_fields_types_get(void *callback, void *userdata);
@@ -102,10 +123,12 @@ void phoneui_utils_idle_set_state(FreeSmartphoneDeviceIdleState state, void (*ca
 void phoneui_utils_resources_get_resource_policy(const char *name, void (*callback) (GError *, FreeSmartphoneUsageResourcePolicy, gpointer), gpointer userdata);
 void phoneui_utils_resources_set_resource_policy(const char *name, FreeSmartphoneUsageResourcePolicy policy, void (*callback) (GError *, gpointer), gpointer userdata);
 
-void phoneui_utils_calls_query(const char *sortby, gboolean sortdesc, gboolean disjunction, int limit_start, int limit, gboolean resolve_number, const GHashTable *options, void (*callback)(GError *, GHashTable **, int, gpointer), gpointer data);
-void phoneui_utils_calls_get_full(const char *sortby, gboolean sortdesc, int limit_start, int limit, gboolean resolve_number, const char *direction, int answered, void (*callback) (GError *, GHashTable **, int, gpointer), gpointer data);
-void phoneui_utils_calls_get(int *count, void (*callback) (GError *, GHashTable **, int, gpointer), void *_data);
+int phoneui_utils_calls_query(const char *sortby, gboolean sortdesc, gboolean disjunction, int limit_start, int limit, gboolean resolve_number, const GHashTable *options, void (*callback)(GError *, GHashTable **, int, gpointer), gpointer data);
+int phoneui_utils_calls_get_full(const char *sortby, gboolean sortdesc, int limit_start, int limit, gboolean resolve_number, const char *direction, int answered, void (*callback) (GError *, GHashTable **, int, gpointer), gpointer data);
+int phoneui_utils_calls_get(int *count, void (*callback) (GError *, GHashTable **, int, gpointer), void *_data);
 int phoneui_utils_call_get(const char *call_path, void (*callback)(GError *, GHashTable*, gpointer), void *data);
+/* like phoneui_utils_call_get, returns a handle for phoneui_utils_cancel */
+int phoneui_utils_call_get_cancellable(const char *call_path, void (*callback)(GError *, GHashTable*, gpointer), void *data);
 
 void phoneui_utils_set_offline_mode(gboolean onoff, void (*callback)(GError *, gpointer userdata), gpointer userdata);
 void phoneui_utils_get_offline_mode(void (*callback)(GError *, gboolean, gpointer userdata), gpointer userdata);
@@ -122,5 +145,14 @@ void phoneui_utils_network_stop_connection_sharing(const char *iface, void (*cal
 int phoneui_utils_init(GKeyFile *keyfile);
 void phoneui_utils_deinit();
 
+/* cancel an operation by the handle it returned - its callback won't be
+ * called anymore. Returns 1 if the operation is already done */
+int phoneui_utils_cancel(int handle);
+
+/* how often a GValue for query, contact and message tables could be reused
+ * from the pool (hits) or had to be allocated (misses), and how many are
+ * pooled right now */
+void phoneui_utils_gvalue_pool_stats_get(guint *hits, guint *misses, guint *pooled);
+
 #endif
 
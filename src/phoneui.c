@@ -32,6 +32,10 @@
 
 #include "phoneui.h"
 #include "phoneui-info.h"
+#include "startup-timing.h"
+#include "latency.h"
+#include "screens.h"
+#include "dbus.h"
 #include "phoneui-utils-sound.h"
 
 /* How to add another function:
@@ -41,14 +45,19 @@
  * add the function declaration to phoneui.h(.in)
  */
 
-#define CONNECT_HELPER(name, type) _phoneui_ ## name = 			\
-		phoneui_get_function("phoneui_backend_" #name, 		\
+#define CONNECT_HELPER(name, type) 					\
+	if (backends[type].library)					\
+		_phoneui_ ## name = 					\
+			phoneui_get_function("phoneui_backend_" #name, 	\
 					backends[type].library)
 
-#define PHONEUI_FUNCTION_CONTENT(name, ...) 				\
+/* backends get loaded with the first function that needs them */
+#define PHONEUI_FUNCTION_CONTENT(name, type, ...) 			\
+	if (!_phoneui_ ## name)						\
+		_phoneui_backend_ensure(type);				\
 	if (_phoneui_ ## name)						\
 		_phoneui_ ## name (__VA_ARGS__);			\
-	else 								\
+	else if (!backends[type].unavailable)				\
 		g_warning("can't find function %s", __FUNCTION__);
 
 /* Calls */
@@ -119,37 +128,55 @@ enum BackendType {
 struct BackendInfo {
 	void *library;
 	const char *name;
+	char *module;
+	gboolean unavailable; /* loading failed, its functions do nothing */
 };
 
 static struct BackendInfo backends[] = {
-					{NULL, "dialer"},
-					{NULL, "messages"},
-					{NULL, "contacts"},
-					{NULL, "calls"},
-					{NULL, "phonelog"},
-					{NULL, "notification"},
-					{NULL, "idle_screen"},
-					{NULL, "settings"},
-					{NULL, "calendar"},
-					{NULL, NULL}
+					{NULL, "dialer", NULL, FALSE},
+					{NULL, "messages", NULL, FALSE},
+					{NULL, "contacts", NULL, FALSE},
+					{NULL, "calls", NULL, FALSE},
+					{NULL, "phonelog", NULL, FALSE},
+					{NULL, "notification", NULL, FALSE},
+					{NULL, "idle_screen", NULL, FALSE},
+					{NULL, "settings", NULL, FALSE},
+					{NULL, "calendar", NULL, FALSE},
+					{NULL, NULL, NULL, FALSE}
 					};
 
+/* what phoneui_init got, for initializing backends loaded later on */
+static struct {
+	gboolean done;
+	int argc;
+	char **argv;
+	void (*exit_cb) ();
+} init_args = { FALSE, 0, NULL, NULL };
+
+/* libraries that got initialized - several backends can share one */
+static GHashTable *inited_libraries = NULL;
+
 static void phoneui_connect();
+static void _phoneui_backend_init(int argc, char **argv, void (*exit_cb) (),
+				  enum BackendType type);
 
 static void
-phoneui_load_backend(GKeyFile *keyfile, enum BackendType type)
+phoneui_load_backend(enum BackendType type)
 {
 	char *library;
+	char *phase;
+	gdouble start = _startup_timing_begin();
 
-	library =
-		g_key_file_get_string(keyfile, backends[type].name, "module", NULL);
+	library = backends[type].module;
 	/* Load library */
 	if (library) {
 		/*FIXME: drop the hardcoded .so*/
 		char *library_path = malloc(strlen(library) + strlen(".so") +
 					strlen(PHONEUI_MODULES_PATH) + 1);
 		if (!library_path) {
-			g_error("Loading %s failed, no memory", library);
+			g_warning("Loading %s failed, no memory", library);
+			backends[type].unavailable = TRUE;
+			return;
 		}
 		strcpy(library_path, PHONEUI_MODULES_PATH);
 		strcat(library_path, library);
@@ -157,14 +184,136 @@ phoneui_load_backend(GKeyFile *keyfile, enum BackendType type)
 		backends[type].library =
 			dlopen(library_path, RTLD_LOCAL | RTLD_LAZY);
 		if (!backends[type].library) {
-			g_error("Loading %s failed: %s", library_path, dlerror());
+			/* a broken backend mustn't take down the caller, it
+			 * might be loaded long after startup */
+			g_warning("Loading %s failed: %s", library_path,
+				  dlerror());
+			backends[type].unavailable = TRUE;
 		}
-		free(library);
 		free(library_path);
+		if (!backends[type].library)
+			return;
 	}
 	else {
-		g_error("Loading failed. library not set.");
+		g_warning("Loading %s failed. library not set.",
+			  backends[type].name);
+		backends[type].unavailable = TRUE;
+		return;
 	}
+
+	phase = g_strdup_printf("backend %s load", backends[type].name);
+	_startup_timing_end(start, phase);
+	g_free(phase);
+}
+
+static void
+_phoneui_backend_init_once(enum BackendType type)
+{
+	char *phase;
+	gdouble start;
+
+	if (!inited_libraries) {
+		inited_libraries = g_hash_table_new(g_direct_hash, g_direct_equal);
+	}
+	if (g_hash_table_lookup(inited_libraries, backends[type].library))
+		return;
+
+	/* FIXME: the char * is a cast hack, since we won't change the content anyway */
+	g_hash_table_insert(inited_libraries, backends[type].library,
+			    (char *) backends[type].name);
+	start = _startup_timing_begin();
+	_phoneui_backend_init(init_args.argc, init_args.argv,
+			      init_args.exit_cb, type);
+	phase = g_strdup_printf("backend %s init", backends[type].name);
+	_startup_timing_end(start, phase);
+	g_free(phase);
+}
+
+/* load the backend if it isn't yet, and init it if phoneui_init already ran */
+static void
+_phoneui_backend_ensure(enum BackendType type)
+{
+	if (backends[type].unavailable)
+		return;
+	if (!backends[type].library) {
+		phoneui_load_backend(type);
+		if (!backends[type].library)
+			return;
+		phoneui_connect();
+	}
+	if (init_args.done) {
+		_phoneui_backend_init_once(type);
+	}
+}
+
+/* which backend holds the screens handled by the screens module */
+static const struct {
+	const char *screen;
+	enum BackendType type;
+} screen_backends[] = {
+	{"dialer", BACKEND_DIALER},
+	{"contacts", BACKEND_CONTACTS},
+	{"messages", BACKEND_MESSAGES},
+	{"quick_settings", BACKEND_SETTINGS},
+	{"sim_manager", BACKEND_SETTINGS},
+	{"idle_screen", BACKEND_IDLE_SCREEN},
+	{"phone_log", BACKEND_PHONELOG},
+	{"calendar", BACKEND_CALENDAR},
+	{NULL, BACKEND_NO}
+};
+
+static int
+_phoneui_screen_destroy(const char *name)
+{
+	int i;
+	char *symbol;
+	void (*destroy) ();
+
+	for (i = 0; screen_backends[i].screen; i++) {
+		if (!strcmp(screen_backends[i].screen, name))
+			break;
+	}
+	if (!screen_backends[i].screen ||
+	    !backends[screen_backends[i].type].library)
+		return 1;
+
+	/* destroying screens is optional for backends */
+	symbol = g_strdup_printf("phoneui_backend_%s_destroy", name);
+	destroy = dlsym(backends[screen_backends[i].type].library, symbol);
+	dlerror();
+	g_free(symbol);
+	if (!destroy)
+		return 1;
+
+	destroy();
+	return 0;
+}
+
+static void
+_phoneui_backend_prewarm(GKeyFile *keyfile)
+{
+	char **names;
+	gsize len, i;
+	int type;
+
+	names = g_key_file_get_string_list(keyfile, "phoneui", "prewarm",
+					   &len, NULL);
+	if (!names)
+		return;
+
+	for (i = 0; i < len; i++) {
+		for (type = 0; type < BACKEND_NO; type++) {
+			if (!strcmp(names[i], backends[type].name))
+				break;
+		}
+		if (type == BACKEND_NO) {
+			g_warning("Unknown backend %s in prewarm list", names[i]);
+			continue;
+		}
+		g_debug("Prewarming backend %s", names[i]);
+		_phoneui_backend_ensure(type);
+	}
+	g_strfreev(names);
 }
 
 void
@@ -175,6 +324,11 @@ phoneui_load(const char *application_name)
 	GKeyFile *keyfile;
 	GKeyFileFlags flags;
 	GError *error = NULL;
+	gdouble start, phase_start;
+	char *bus;
+
+	start = _startup_timing_begin();
+	phase_start = start;
 	keyfile = g_key_file_new();
 	flags = G_KEY_FILE_KEEP_COMMENTS | G_KEY_FILE_KEEP_TRANSLATIONS;
 	if (!g_key_file_load_from_file
@@ -182,19 +336,40 @@ phoneui_load(const char *application_name)
 		g_error("%s", error->message);
 		return;
 	}
+	_startup_timing_end(phase_start, "config");
 
+	bus = g_key_file_get_string(keyfile, "phoneui", "bus", NULL);
+	_dbus_set_bus(bus);
+	g_free(bus);
+
+	/* only remember the modules - the backends get loaded when they
+	 * are needed first, or below if listed for prewarming */
 	for (i = 0 ; i < BACKEND_NO ; i++) {
-		phoneui_load_backend(keyfile, i);
+		backends[i].module = g_key_file_get_string(keyfile,
+					backends[i].name, "module", NULL);
+		if (!backends[i].module) {
+			g_warning("No module set for backend %s", backends[i].name);
+		}
 	}
 
-	phoneui_connect();
+	phase_start = _startup_timing_begin();
+	_phoneui_backend_prewarm(keyfile);
+	_startup_timing_end(phase_start, "prewarm");
 	/* init phone utils */
 	/*FIXME: should be in init, does it cause problems?*/
+	phase_start = _startup_timing_begin();
 	phone_utils_init();
+	_startup_timing_end(phase_start, "phone_utils init");
 
+	phase_start = _startup_timing_begin();
 	phoneui_utils_init(keyfile);
+	_startup_timing_end(phase_start, "utils init");
+	phoneui_info_load_config(keyfile);
+	_latency_load_config(keyfile);
+	_screens_init(keyfile, _phoneui_screen_destroy);
 
 	g_key_file_free(keyfile);
+	_startup_timing_end(start, "load");
 }
 
 
@@ -294,41 +469,47 @@ _phoneui_backend_loop(enum BackendType type)
 void
 phoneui_init(int argc, char **argv, void (*exit_cb) ())
 {
-	/* the hash table is used to make sure we only init one backend once */
 	int i;
-	GHashTable *inits;
-	inits = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, NULL);
+	gdouble start, phase_start;
+
+	start = _startup_timing_begin();
+	init_args.argc = argc;
+	init_args.argv = argv;
+	init_args.exit_cb = exit_cb;
+	init_args.done = TRUE;
 
+	/* init the prewarmed backends, the others get inited when loaded */
 	for (i = 0 ; i < BACKEND_NO ; i++) {
-		if (!g_hash_table_lookup(inits, backends[i].library)) {
-			/* FIXME: the char * is a cast hack, since we won't change the content anyway */
-			g_hash_table_insert(inits, backends[i].library, (char *) backends[i].name);
-			_phoneui_backend_init(argc, argv, exit_cb, i);
+		if (backends[i].library) {
+			_phoneui_backend_init_once(i);
 		}
 	}
 
-	g_hash_table_destroy(inits);
-
+	phase_start = _startup_timing_begin();
 	phoneui_info_init();
+	_startup_timing_end(phase_start, "info init");
+	_startup_timing_end(start, "init");
 }
 
 void
 phoneui_deinit()
 {
-	/* the hash table is used to make sure we only init one backend once */
 	int i;
-	GHashTable *inits;
-	inits = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, NULL);
 
+	_screens_deinit();
+
+	/* only deinit what got inited - once per library */
 	for (i = 0 ; i < BACKEND_NO ; i++) {
-		if (!g_hash_table_lookup(inits, backends[i].library)) {
-			/* FIXME: the char * is a cast hack, since we won't change the content anyway */
-			g_hash_table_insert(inits, backends[i].library, (char *) backends[i].name);
+		if (inited_libraries && backends[i].library &&
+		    g_hash_table_remove(inited_libraries, backends[i].library)) {
 			_phoneui_backend_deinit(i);
 		}
 	}
-
-	g_hash_table_destroy(inits);
+	if (inited_libraries) {
+		g_hash_table_destroy(inited_libraries);
+		inited_libraries = NULL;
+	}
+	init_args.done = FALSE;
 
 	phoneui_info_deinit();
 	phoneui_utils_deinit();
@@ -346,6 +527,11 @@ phoneui_loop()
 	}
 #else
 	/* FIXME: until we add support for threads, run only one loop */
+	_phoneui_backend_ensure(BACKEND_CALLS);
+	if (!backends[BACKEND_CALLS].library) {
+		g_warning("No backend to run the main loop");
+		return;
+	}
 	_phoneui_backend_loop(BACKEND_CALLS);
 #endif
 }
@@ -354,142 +540,153 @@ phoneui_loop()
 void
 phoneui_incoming_call_show(const int id, const int status, const char *number)
 {
-	PHONEUI_FUNCTION_CONTENT(incoming_call_show, id, status, number);
+	PHONEUI_FUNCTION_CONTENT(incoming_call_show, BACKEND_CALLS, id, status, number);
 }
 void
 phoneui_incoming_call_hide(const int id)
 {
-	PHONEUI_FUNCTION_CONTENT(incoming_call_hide, id);
+	PHONEUI_FUNCTION_CONTENT(incoming_call_hide, BACKEND_CALLS, id);
 }
 void
 phoneui_outgoing_call_show(const int id, const int status, const char *number)
 {
-	PHONEUI_FUNCTION_CONTENT(outgoing_call_show, id, status, number);
+	PHONEUI_FUNCTION_CONTENT(outgoing_call_show, BACKEND_CALLS, id, status, number);
 }
 void
 phoneui_outgoing_call_hide(const int id)
 {
-	PHONEUI_FUNCTION_CONTENT(outgoing_call_hide, id);
+	PHONEUI_FUNCTION_CONTENT(outgoing_call_hide, BACKEND_CALLS, id);
 }
 
 /* Contacts */
 void
 phoneui_contacts_show()
 {
-	PHONEUI_FUNCTION_CONTENT(contacts_show);
+	PHONEUI_FUNCTION_CONTENT(contacts_show, BACKEND_CONTACTS);
+	_screens_shown("contacts");
 }
 void
 phoneui_contacts_contact_show(const char *contact_path)
 {
-	PHONEUI_FUNCTION_CONTENT(contacts_contact_show, contact_path);
+	PHONEUI_FUNCTION_CONTENT(contacts_contact_show, BACKEND_CONTACTS, contact_path);
 }
 void
 phoneui_contacts_contact_new(GHashTable *values)
 {
-	PHONEUI_FUNCTION_CONTENT(contacts_contact_new, values);
+	PHONEUI_FUNCTION_CONTENT(contacts_contact_new, BACKEND_CONTACTS, values);
 }
 void
 phoneui_contacts_contact_edit(const char *contact_path)
 {
-	PHONEUI_FUNCTION_CONTENT(contacts_contact_edit, contact_path);
+	PHONEUI_FUNCTION_CONTENT(contacts_contact_edit, BACKEND_CONTACTS, contact_path);
 }
 
 /* Messages */
 void
 phoneui_messages_show()
 {
-	PHONEUI_FUNCTION_CONTENT(messages_show);
+	PHONEUI_FUNCTION_CONTENT(messages_show, BACKEND_MESSAGES);
+	_screens_shown("messages");
 }
 void
 phoneui_messages_message_show(const char *path)
 {
-	PHONEUI_FUNCTION_CONTENT(messages_message_show, path);
+	PHONEUI_FUNCTION_CONTENT(messages_message_show, BACKEND_MESSAGES, path);
 }
 void
 phoneui_messages_message_new(GHashTable *options)
 {
-	PHONEUI_FUNCTION_CONTENT(messages_message_new, options);
+	PHONEUI_FUNCTION_CONTENT(messages_message_new, BACKEND_MESSAGES, options);
 }
 
 /* Dialer */
 void
 phoneui_dialer_show()
 {
-	PHONEUI_FUNCTION_CONTENT(dialer_show);
+	PHONEUI_FUNCTION_CONTENT(dialer_show, BACKEND_DIALER);
+	_screens_shown("dialer");
 }
 
 /* Notifications */
 void
 phoneui_dialog_show(const int type)
 {
-	PHONEUI_FUNCTION_CONTENT(dialog_show, type);
+	PHONEUI_FUNCTION_CONTENT(dialog_show, BACKEND_NOTIFICATION, type);
 }
 void
 phoneui_sim_auth_show(const int status)
 {
-	PHONEUI_FUNCTION_CONTENT(sim_auth_show, status);
+	PHONEUI_FUNCTION_CONTENT(sim_auth_show, BACKEND_NOTIFICATION, status);
 }
 void
 phoneui_sim_auth_hide(const int status)
 {
-	PHONEUI_FUNCTION_CONTENT(sim_auth_hide, status);
+	PHONEUI_FUNCTION_CONTENT(sim_auth_hide, BACKEND_NOTIFICATION, status);
 }
 void
 phoneui_ussd_show(int mode, const char *message)
 {
-	PHONEUI_FUNCTION_CONTENT(ussd_show, mode, message);
+	PHONEUI_FUNCTION_CONTENT(ussd_show, BACKEND_NOTIFICATION, mode, message);
 }
 
 /* Quick Settings */
 void
 phoneui_quick_settings_show()
 {
-	PHONEUI_FUNCTION_CONTENT(quick_settings_show);
+	PHONEUI_FUNCTION_CONTENT(quick_settings_show, BACKEND_SETTINGS);
+	_screens_shown("quick_settings");
 }
 void
 phoneui_quick_settings_hide()
 {
-	PHONEUI_FUNCTION_CONTENT(quick_settings_hide);
+	PHONEUI_FUNCTION_CONTENT(quick_settings_hide, BACKEND_SETTINGS);
+	_screens_hidden("quick_settings");
 }
 
 /* Idle Screen */
 void
 phoneui_idle_screen_show()
 {
-	PHONEUI_FUNCTION_CONTENT(idle_screen_show);
+	PHONEUI_FUNCTION_CONTENT(idle_screen_show, BACKEND_IDLE_SCREEN);
+	_screens_shown("idle_screen");
 }
 void
 phoneui_idle_screen_hide()
 {
-	PHONEUI_FUNCTION_CONTENT(idle_screen_hide);
+	PHONEUI_FUNCTION_CONTENT(idle_screen_hide, BACKEND_IDLE_SCREEN);
+	_screens_hidden("idle_screen");
 }
 void
 phoneui_idle_screen_toggle()
 {
-	PHONEUI_FUNCTION_CONTENT(idle_screen_toggle);
+	PHONEUI_FUNCTION_CONTENT(idle_screen_toggle, BACKEND_IDLE_SCREEN);
 }
 
 void
 phoneui_phone_log_show()
 {
-	PHONEUI_FUNCTION_CONTENT(phone_log_show);
+	PHONEUI_FUNCTION_CONTENT(phone_log_show, BACKEND_PHONELOG);
+	_screens_shown("phone_log");
 }
 void
 phoneui_phone_log_hide()
 {
-	PHONEUI_FUNCTION_CONTENT(phone_log_hide);
+	PHONEUI_FUNCTION_CONTENT(phone_log_hide, BACKEND_PHONELOG);
+	_screens_hidden("phone_log");
 }
 
 void
 phoneui_sim_manager_show()
 {
-	PHONEUI_FUNCTION_CONTENT(sim_manager_show);
+	PHONEUI_FUNCTION_CONTENT(sim_manager_show, BACKEND_SETTINGS);
+	_screens_shown("sim_manager");
 }
 
 void
 phoneui_sim_manager_hide()
 {
-	PHONEUI_FUNCTION_CONTENT(sim_manager_hide);
+	PHONEUI_FUNCTION_CONTENT(sim_manager_hide, BACKEND_SETTINGS);
+	_screens_hidden("sim_manager");
 }
 
 
@@ -497,23 +694,24 @@ phoneui_sim_manager_hide()
 void
 phoneui_calendar_month_show(const int month)
 {
-	PHONEUI_FUNCTION_CONTENT(calendar_month_show, month);
+	PHONEUI_FUNCTION_CONTENT(calendar_month_show, BACKEND_CALENDAR, month);
+	_screens_shown("calendar");
 }
 
 void
 phoneui_calendar_day_show(const char *day)
 {
-	PHONEUI_FUNCTION_CONTENT(calendar_day_show, day);
+	PHONEUI_FUNCTION_CONTENT(calendar_day_show, BACKEND_CALENDAR, day);
 }
 
 void
 phoneui_calendar_date_show(const char *path)
 {
-	PHONEUI_FUNCTION_CONTENT(calendar_date_show, path);
+	PHONEUI_FUNCTION_CONTENT(calendar_date_show, BACKEND_CALENDAR, path);
 }
 
 void
 phoneui_calendar_date_new(GHashTable *options)
 {
-	PHONEUI_FUNCTION_CONTENT(calendar_date_new, options);
+	PHONEUI_FUNCTION_CONTENT(calendar_date_new, BACKEND_CALENDAR, options);
 }
@@ -0,0 +1,326 @@
+/*
+ *  Copyright (C) 2026
+ *      Authors (alphabetical) :
+ *		agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <glib-object.h>
+#include "phoneui-info.h"
+#include "phoneui-utils.h"
+#include "query-cache.h"
+
+struct _cache_entry {
+	enum PhoneUiPimDomain domain;
+	char *key;
+	GHashTable **results;
+	int count;
+};
+
+struct _cache_domain {
+	const char *name;
+	gboolean enabled;
+	gboolean registered;
+	guint generation;
+	int (*register_changes)(void (*)(void *, const char *,
+				enum PhoneuiInfoChangeType), void *);
+};
+
+struct _cache_deliver_pack {
+	struct _cancellable *cancellable;
+	GHashTable **results;
+	int count;
+	void (*callback)(GError *, GHashTable **, int, gpointer);
+	gpointer data;
+};
+
+/* only the domains opimd signals changes for can be cached */
+static struct _cache_domain domains[] = {
+	[PHONEUI_PIM_DOMAIN_CALLS] = {"calls", FALSE, FALSE, 0,
+				      phoneui_info_register_call_changes},
+	[PHONEUI_PIM_DOMAIN_CONTACTS] = {"contacts", FALSE, FALSE, 0,
+					 phoneui_info_register_contact_changes},
+	[PHONEUI_PIM_DOMAIN_DATES] = {NULL, FALSE, FALSE, 0, NULL},
+	[PHONEUI_PIM_DOMAIN_MESSAGES] = {"messages", FALSE, FALSE, 0,
+					 phoneui_info_register_message_changes},
+	[PHONEUI_PIM_DOMAIN_NOTES] = {NULL, FALSE, FALSE, 0, NULL},
+	[PHONEUI_PIM_DOMAIN_TASKS] = {NULL, FALSE, FALSE, 0, NULL},
+};
+#define CACHE_DOMAINS (sizeof(domains) / sizeof(domains[0]))
+
+static void _cache_changed(void *data, const char *path,
+			   enum PhoneuiInfoChangeType type);
+
+static int max_entries = 16;
+/* key -> struct _cache_entry */
+static GHashTable *entries = NULL;
+/* keys, oldest first - for dropping the oldest entry when full */
+static GQueue *order = NULL;
+
+static void
+_cache_entry_free(gpointer data)
+{
+	int i;
+	struct _cache_entry *entry = data;
+
+	for (i = 0; i < entry->count; i++) {
+		g_hash_table_unref(entry->results[i]);
+	}
+	g_free(entry->results);
+	free(entry->key);
+	free(entry);
+}
+
+GHashTable **
+_query_results_ref(GHashTable **results, int count)
+{
+	int i;
+	GHashTable **ret = g_malloc(MAX(count, 1) * sizeof(GHashTable *));
+
+	for (i = 0; i < count; i++) {
+		ret[i] = g_hash_table_ref(results[i]);
+	}
+	return ret;
+}
+
+void
+_query_cache_load_config(GKeyFile *keyfile)
+{
+	char **names;
+	gsize len, i, d;
+	int size;
+
+	names = g_key_file_get_string_list(keyfile, "pim", "cache", &len, NULL);
+	for (i = 0; names && i < len; i++) {
+		for (d = 0; d < CACHE_DOMAINS; d++) {
+			if (domains[d].name && !strcmp(domains[d].name, names[i]))
+				break;
+		}
+		if (d == CACHE_DOMAINS) {
+			g_warning("Can't cache queries of %s", names[i]);
+			continue;
+		}
+		g_debug("Caching queries of %s", names[i]);
+		domains[d].enabled = TRUE;
+	}
+	g_strfreev(names);
+
+	size = g_key_file_get_integer(keyfile, "pim", "cache_size", NULL);
+	if (size > 0) {
+		max_entries = size;
+	}
+}
+
+static gint
+_compare_keys(gconstpointer a, gconstpointer b)
+{
+	return strcmp((const char *) a, (const char *) b);
+}
+
+gboolean
+_query_cache_enabled(enum PhoneUiPimDomain domain)
+{
+	if ((guint) domain >= CACHE_DOMAINS || !domains[domain].enabled)
+		return FALSE;
+	/* before the query gets fired, so no change can slip through */
+	if (!domains[domain].registered) {
+		domains[domain].register_changes(_cache_changed,
+						 GINT_TO_POINTER(domain));
+		domains[domain].registered = TRUE;
+	}
+	return TRUE;
+}
+
+char *
+_query_key(enum PhoneUiPimDomain domain, const char *sortby,
+	   gboolean sortdesc, gboolean disjunction, int limit_start,
+	   int limit, gboolean resolve_number, const GHashTable *options)
+{
+	GString *key;
+	GList *keys, *l;
+	char *contents;
+
+	key = g_string_new(NULL);
+	g_string_printf(key, "%d|%s|%d|%d|%d|%d|%d", domain,
+			(sortby) ? sortby : "", sortdesc, disjunction,
+			limit_start, limit, resolve_number);
+	if (options) {
+		/* the options table has no order of its own */
+		keys = g_hash_table_get_keys((GHashTable *) options);
+		keys = g_list_sort(keys, _compare_keys);
+		for (l = keys; l; l = l->next) {
+			if (((const char *) l->data)[0] == '_')
+				continue;
+			contents = g_strdup_value_contents
+				(g_hash_table_lookup((GHashTable *) options,
+						     l->data));
+			g_string_append_printf(key, "|%s=%s",
+					       (const char *) l->data, contents);
+			g_free(contents);
+		}
+		g_list_free(keys);
+	}
+
+	contents = strdup(key->str);
+	g_string_free(key, TRUE);
+	return contents;
+}
+
+static gboolean
+_cache_deliver_idle(gpointer data)
+{
+	struct _cache_deliver_pack *pack = data;
+
+	if (_cancellable_cancelled(pack->cancellable)) {
+		_cancel_results_drop(pack->results, pack->count);
+	}
+	else {
+		pack->callback(NULL, pack->results, pack->count, pack->data);
+	}
+	_cancellable_free(pack->cancellable);
+	free(pack);
+	return FALSE;
+}
+
+int
+_query_cache_deliver(const char *key, struct _cancellable *cancellable,
+		     void (*callback)(GError *, GHashTable **, int, gpointer),
+		     gpointer data)
+{
+	struct _cache_entry *entry;
+	struct _cache_deliver_pack *pack;
+
+	if (!entries || !key || !callback)
+		return 0;
+	entry = g_hash_table_lookup(entries, key);
+	if (!entry)
+		return 0;
+
+	pack = malloc(sizeof(*pack));
+	if (!pack)
+		return 0;
+	g_debug("Answering query from the cache (%d entries)", entry->count);
+	pack->cancellable = cancellable;
+	pack->results = _query_results_ref(entry->results, entry->count);
+	pack->count = entry->count;
+	pack->callback = callback;
+	pack->data = data;
+	g_idle_add(_cache_deliver_idle, pack);
+	return 1;
+}
+
+static gboolean
+_entry_in_domain(gpointer key, gpointer value, gpointer data)
+{
+	(void) key;
+	struct _cache_entry *entry = value;
+
+	return entry->domain == (enum PhoneUiPimDomain) GPOINTER_TO_INT(data);
+}
+
+static void
+_cache_changed(void *data, const char *path, enum PhoneuiInfoChangeType type)
+{
+	(void) path;
+	(void) type;
+	GList *l, *next;
+	enum PhoneUiPimDomain domain = GPOINTER_TO_INT(data);
+
+	/* sorting, limits and filters make patching the results
+	 * no better than asking opimd again */
+	domains[domain].generation++;
+	if (!entries)
+		return;
+	g_hash_table_foreach_remove(entries, _entry_in_domain, data);
+	for (l = order->head; l; l = next) {
+		next = l->next;
+		if (!g_hash_table_lookup(entries, l->data)) {
+			free(l->data);
+			g_queue_delete_link(order, l);
+		}
+	}
+}
+
+guint
+_query_cache_generation(enum PhoneUiPimDomain domain)
+{
+	if ((guint) domain >= CACHE_DOMAINS)
+		return 0;
+	return domains[domain].generation;
+}
+
+void
+_query_cache_store(enum PhoneUiPimDomain domain, guint generation,
+		   const char *key, GHashTable **results, int count)
+{
+	char *oldest;
+	struct _cache_entry *entry;
+
+	if (!key || count < 0 || (guint) domain >= CACHE_DOMAINS)
+		return;
+	/* changed while the query was running */
+	if (domains[domain].generation != generation)
+		return;
+
+	if (!entries) {
+		entries = g_hash_table_new_full(g_str_hash, g_str_equal,
+						NULL, _cache_entry_free);
+		order = g_queue_new();
+	}
+	if (g_hash_table_lookup(entries, key))
+		return;
+
+	while (g_hash_table_size(entries) >= (guint) max_entries) {
+		oldest = g_queue_pop_head(order);
+		g_hash_table_remove(entries, oldest);
+		free(oldest);
+	}
+
+	entry = malloc(sizeof(*entry));
+	if (!entry)
+		return;
+	entry->domain = domain;
+	entry->key = strdup(key);
+	entry->results = _query_results_ref(results, count);
+	entry->count = count;
+	g_hash_table_insert(entries, entry->key, entry);
+	g_queue_push_tail(order, strdup(key));
+}
+
+void
+_query_cache_deinit()
+{
+	guint i;
+
+	if (entries) {
+		g_hash_table_destroy(entries);
+		entries = NULL;
+	}
+	if (order) {
+		while (!g_queue_is_empty(order)) {
+			free(g_queue_pop_head(order));
+		}
+		g_queue_free(order);
+		order = NULL;
+	}
+	/* phoneui_info_deinit dropped the subscriptions */
+	for (i = 0; i < CACHE_DOMAINS; i++) {
+		domains[i].registered = FALSE;
+	}
+}
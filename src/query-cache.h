@@ -0,0 +1,51 @@
+/*
+ *  Copyright (C) 2026
+ *      Authors (alphabetical) :
+ *		agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ */
+#ifndef _QUERY_CACHE_H
+#define _QUERY_CACHE_H
+
+#include <glib.h>
+#include "phoneui-utils.h"
+#include "cancel.h"
+
+/* results of repeated PIM queries, for the domains listed in the cache
+ * setting of the [pim] section. Everything of a domain is dropped when
+ * opimd signals a new, updated or deleted entry there */
+void _query_cache_load_config(GKeyFile *keyfile);
+/* identifies a query by all its parameters */
+char *_query_key(enum PhoneUiPimDomain domain, const char *sortby,
+		 gboolean sortdesc, gboolean disjunction, int limit_start,
+		 int limit, gboolean resolve_number, const GHashTable *options);
+gboolean _query_cache_enabled(enum PhoneUiPimDomain domain);
+/* returns new references to the tables */
+GHashTable **_query_results_ref(GHashTable **results, int count);
+/* returns 1 if the results are known and will be delivered from the
+ * mainloop - with new references to the cached tables. Takes over the
+ * cancellable then */
+int _query_cache_deliver(const char *key, struct _cancellable *cancellable,
+			 void (*callback)(GError *, GHashTable **, int, gpointer),
+			 gpointer data);
+/* results only get stored if the domain didn't change since
+ * the generation was taken */
+guint _query_cache_generation(enum PhoneUiPimDomain domain);
+void _query_cache_store(enum PhoneUiPimDomain domain, guint generation,
+			const char *key, GHashTable **results, int count);
+void _query_cache_deinit();
+
+#endif
@@ -0,0 +1,233 @@
+/*
+ *  Copyright (C) 2026
+ *      Authors (alphabetical) :
+ *		agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include "phoneui.h"
+#include "screens.h"
+
+struct _screen {
+	const char *name;
+	gboolean visible;
+	gboolean alive;
+	gboolean pinned;
+};
+
+/* the screens that have a show and a hide, or where the backend reports
+ * showing and hiding via phoneui_screen_shown and phoneui_screen_hidden */
+static struct _screen screens[] = {
+	{"dialer", FALSE, FALSE, FALSE},
+	{"contacts", FALSE, FALSE, FALSE},
+	{"messages", FALSE, FALSE, FALSE},
+	{"quick_settings", FALSE, FALSE, FALSE},
+	{"sim_manager", FALSE, FALSE, FALSE},
+	{"idle_screen", FALSE, FALSE, FALSE},
+	{"phone_log", FALSE, FALSE, FALSE},
+	{"calendar", FALSE, FALSE, FALSE},
+	{NULL, FALSE, FALSE, FALSE}
+};
+
+enum _screens_policy {
+	SCREENS_POLICY_KEEP = 0,
+	SCREENS_POLICY_DESTROY,
+	SCREENS_POLICY_MRU
+};
+
+static enum _screens_policy policy = SCREENS_POLICY_KEEP;
+static int mru_size = 3;
+static int (*destroy_func) (const char *name) = NULL;
+/* hidden screens still held by the backends, most recently hidden first */
+static GQueue *hidden = NULL;
+static guint trim_source = 0;
+
+static struct _screen *
+_screen_get(const char *name)
+{
+	int i;
+
+	if (!name)
+		return NULL;
+	for (i = 0; screens[i].name; i++) {
+		if (!strcmp(screens[i].name, name))
+			return &screens[i];
+	}
+	return NULL;
+}
+
+static void
+_screen_destroy(struct _screen *screen)
+{
+	g_queue_remove(hidden, screen);
+	if (!destroy_func || destroy_func(screen->name)) {
+		/* backend can't destroy it, nothing to gain by retrying */
+		g_debug("Screen %s can't be destroyed", screen->name);
+		return;
+	}
+	g_debug("Destroyed screen %s", screen->name);
+	screen->alive = FALSE;
+}
+
+static void
+_screens_trim(guint keep)
+{
+	while (hidden && g_queue_get_length(hidden) > keep) {
+		_screen_destroy(g_queue_peek_tail(hidden));
+	}
+}
+
+static guint
+_screens_policy_size()
+{
+	switch (policy) {
+	case SCREENS_POLICY_DESTROY:
+		return 0;
+	case SCREENS_POLICY_MRU:
+		return mru_size;
+	default:
+		return G_MAXUINT;
+	}
+}
+
+static gboolean
+_screens_trim_idle(gpointer data)
+{
+	(void) data;
+
+	trim_source = 0;
+	_screens_trim(_screens_policy_size());
+	return FALSE;
+}
+
+void
+_screens_init(GKeyFile *keyfile, int (*destroy) (const char *name))
+{
+	char *s;
+	char **pinned;
+	gsize len, i;
+	int size;
+	struct _screen *screen;
+
+	destroy_func = destroy;
+	hidden = g_queue_new();
+
+	s = g_key_file_get_string(keyfile, "screens", "policy", NULL);
+	if (s) {
+		if (!strcmp(s, "destroy"))
+			policy = SCREENS_POLICY_DESTROY;
+		else if (!strcmp(s, "mru"))
+			policy = SCREENS_POLICY_MRU;
+		else if (!strcmp(s, "keep"))
+			policy = SCREENS_POLICY_KEEP;
+		else
+			g_warning("Unknown screen policy %s", s);
+		g_free(s);
+	}
+	size = g_key_file_get_integer(keyfile, "screens", "mru_size", NULL);
+	if (size > 0) {
+		mru_size = size;
+	}
+
+	pinned = g_key_file_get_string_list(keyfile, "screens", "pinned",
+					    &len, NULL);
+	for (i = 0; pinned && i < len; i++) {
+		screen = _screen_get(pinned[i]);
+		if (screen)
+			screen->pinned = TRUE;
+		else
+			g_warning("Unknown screen %s in pinned list", pinned[i]);
+	}
+	g_strfreev(pinned);
+
+	g_debug("Screen policy %d, keeping %d screens", policy, mru_size);
+}
+
+void
+_screens_deinit()
+{
+	int i;
+
+	if (trim_source) {
+		g_source_remove(trim_source);
+		trim_source = 0;
+	}
+	if (hidden) {
+		g_queue_free(hidden);
+		hidden = NULL;
+	}
+	for (i = 0; screens[i].name; i++) {
+		screens[i].visible = FALSE;
+		screens[i].alive = FALSE;
+	}
+	destroy_func = NULL;
+}
+
+void
+_screens_shown(const char *name)
+{
+	struct _screen *screen = _screen_get(name);
+
+	if (!screen)
+		return;
+	screen->visible = TRUE;
+	screen->alive = TRUE;
+	if (hidden)
+		g_queue_remove(hidden, screen);
+}
+
+void
+_screens_hidden(const char *name)
+{
+	struct _screen *screen = _screen_get(name);
+
+	if (!screen || !hidden)
+		return;
+	screen->visible = FALSE;
+	if (!screen->alive || screen->pinned)
+		return;
+
+	g_queue_remove(hidden, screen);
+	g_queue_push_head(hidden, screen);
+	/* don't destroy the screen from within the code hiding it */
+	if (!trim_source && g_queue_get_length(hidden) > _screens_policy_size()) {
+		trim_source = g_idle_add(_screens_trim_idle, NULL);
+	}
+}
+
+void
+phoneui_screen_shown(const char *name)
+{
+	_screens_shown(name);
+}
+
+void
+phoneui_screen_hidden(const char *name)
+{
+	_screens_hidden(name);
+}
+
+void
+phoneui_screens_evict(int keep)
+{
+	if (!hidden)
+		return;
+	g_debug("Evicting hidden screens, keeping %d", keep);
+	_screens_trim((keep > 0) ? (guint) keep : 0);
+}
@@ -0,0 +1,34 @@
+/*
+ *  Copyright (C) 2026
+ *      Authors (alphabetical) :
+ *		agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ */
+
+#ifndef _SCREENS_H
+#define _SCREENS_H
+
+#include <glib.h>
+
+/* keeps track of which screens the backends hold and destroys hidden ones
+ * according to the [screens] policy. destroy gets the screen name and
+ * returns 0 if the backend dropped the screen */
+void _screens_init(GKeyFile *keyfile, int (*destroy) (const char *name));
+void _screens_deinit();
+void _screens_shown(const char *name);
+void _screens_hidden(const char *name);
+
+#endif
@@ -0,0 +1,99 @@
+/*
+ *  Copyright (C) 2026
+ *      Authors (alphabetical) :
+ *		agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ */
+
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include "phoneui.h"
+#include "startup-timing.h"
+
+struct _startup_phase {
+	char *name;
+	gdouble start;
+	gdouble duration;
+};
+
+/* started with the first phase, all times are relative to it */
+static GTimer *_timer = NULL;
+static GArray *_phases = NULL;
+
+gdouble
+_startup_timing_begin()
+{
+	if (!_timer) {
+		_timer = g_timer_new();
+		_phases = g_array_new(FALSE, FALSE, sizeof(struct _startup_phase));
+	}
+	return g_timer_elapsed(_timer, NULL);
+}
+
+void
+_startup_timing_end(gdouble start, const char *phase)
+{
+	struct _startup_phase p;
+
+	if (!_timer)
+		return;
+
+	p.name = strdup(phase);
+	p.start = start;
+	p.duration = g_timer_elapsed(_timer, NULL) - start;
+	g_array_append_val(_phases, p);
+	g_debug("Startup: %s took %.1f ms", phase, p.duration * 1000);
+}
+
+double
+phoneui_startup_time_get(const char *phase)
+{
+	guint i;
+	struct _startup_phase *p;
+
+	if (!_phases || !phase)
+		return -1;
+
+	for (i = 0; i < _phases->len; i++) {
+		p = &g_array_index(_phases, struct _startup_phase, i);
+		if (!strcmp(p->name, phase))
+			return p->duration * 1000;
+	}
+	return -1;
+}
+
+void
+phoneui_startup_times_dump()
+{
+	guint i;
+	struct _startup_phase *p;
+
+	if (!_phases) {
+		g_message("Startup: no phases recorded");
+		return;
+	}
+
+	/* phases are recorded when they end, nested ones before the
+	 * outer ones - the start offset shows where they belong */
+	for (i = 0; i < _phases->len; i++) {
+		p = &g_array_index(_phases, struct _startup_phase, i);
+		g_message("Startup: +%8.1f ms %8.1f ms  %s",
+			  p->start * 1000, p->duration * 1000, p->name);
+	}
+}